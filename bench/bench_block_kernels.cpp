@@ -0,0 +1,69 @@
+// Times every block-averaging kernel available on this CPU over a synthetic 1080p RGB24 frame.
+// Build: cmake -DASCII_BUILD_BENCHMARKS=ON, or
+//        g++ -std=c++17 -O3 -Isrc bench/bench_block_kernels.cpp src/BlockKernels.cpp
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BlockKernels.hpp"
+
+using namespace AsciiVideoFilter;
+
+static double timeFrame(BlockSumFn fn, const std::vector<uint8_t>& image, int width, int height,
+                        int stride, int blockWidth, int blockHeight, int iterations, uint64_t& checksum) {
+    const int cols = width / blockWidth;
+    const int rows = height / blockHeight;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        for (int by = 0; by < rows; ++by) {
+            const uint8_t* row = image.data() + by * blockHeight * stride;
+            for (int bx = 0; bx < cols; ++bx) {
+                BlockSums sums;
+                fn(row + bx * blockWidth * 3, stride, blockWidth, blockHeight, sums);
+                checksum += sums.r + sums.g + sums.b + sums.brightness;
+            }
+        }
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / iterations;
+}
+
+int main(int argc, char* argv[]) {
+    const int width = 1920, height = 1080, stride = width * 3;
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 50;
+
+    std::vector<uint8_t> image(stride * height + BlockKernels::kReadPadding);
+    std::mt19937 rng(42);
+    for (auto& byte : image) {
+        byte = static_cast<uint8_t>(rng());
+    }
+
+    const int blockSizes[][2] = {{4, 8}, {8, 12}, {16, 16}};
+    const auto kernels = BlockKernels::available();
+
+    std::cout << "Block averaging, " << width << "x" << height << " RGB24, " << iterations << " iterations\n";
+    std::cout << std::left << std::setw(8) << "block" << std::setw(10) << "kernel"
+              << std::right << std::setw(12) << "ms/frame" << std::setw(10) << "speedup" << "\n";
+
+    for (const auto& size : blockSizes) {
+        double scalarMs = 0.0;
+        uint64_t reference = 0;
+        for (const auto& kernel : kernels) {
+            uint64_t checksum = 0;
+            double ms = timeFrame(kernel.fn, image, width, height, stride, size[0], size[1], iterations, checksum);
+            if (kernel.fn == &BlockKernels::sumScalar) {
+                scalarMs = ms;
+                reference = checksum;
+            }
+            std::cout << std::left << std::setw(8) << (std::to_string(size[0]) + "x" + std::to_string(size[1]))
+                      << std::setw(10) << kernel.name
+                      << std::right << std::fixed << std::setprecision(3) << std::setw(12) << ms
+                      << std::setprecision(2) << std::setw(9) << scalarMs / ms << "x"
+                      << (checksum == reference ? "" : "  MISMATCH") << "\n";
+        }
+    }
+    return 0;
+}
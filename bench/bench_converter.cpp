@@ -0,0 +1,94 @@
+// Times AsciiConverter::convert per conversion mode on a synthetic yuv420p frame.
+// Build with cmake -DASCII_BUILD_BENCHMARKS=ON; run as bench_converter [width height iterations].
+// Reports ms/frame per mode and block size. No results have been recorded yet.
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "AsciiConverter.hpp"
+
+extern "C" {
+    #include <libavutil/frame.h>
+    #include <libswscale/swscale.h>
+}
+
+using namespace AsciiVideoFilter;
+
+int main(int argc, char* argv[]) {
+    const int width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const int iterations = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) {
+        std::cerr << "Failed to allocate source frame\n";
+        return 1;
+    }
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 32) < 0) {
+        std::cerr << "Failed to allocate source frame\n";
+        return 1;
+    }
+
+    // Smooth gradients plus noise, so neither swscale nor the block loop sees flat input
+    std::mt19937 rng(7);
+    for (int plane = 0; plane < 3; ++plane) {
+        const int planeHeight = plane == 0 ? height : (height + 1) / 2;
+        const int planeWidth = plane == 0 ? width : (width + 1) / 2;
+        for (int y = 0; y < planeHeight; ++y) {
+            for (int x = 0; x < planeWidth; ++x) {
+                frame->data[plane][y * frame->linesize[plane] + x] = static_cast<uint8_t>((x + y * 3 + plane * 50 + (rng() & 15)) & 0xFF);
+            }
+        }
+    }
+
+    struct Case {
+        const char* name;
+        ConversionMode mode;
+        int filter;
+    };
+    const Case cases[] = {
+        {"rgb", ConversionMode::RGB, SWS_BILINEAR},
+        {"yuv", ConversionMode::YUV, SWS_BILINEAR},
+        {"scale/area", ConversionMode::SCALE, SWS_AREA},
+        {"scale/bilinear", ConversionMode::SCALE, SWS_BILINEAR},
+    };
+    const int blockSizes[][2] = {{4, 8}, {8, 12}, {16, 16}};
+
+    std::cout << std::left << std::setw(8) << "block" << std::setw(16) << "mode"
+              << std::right << std::setw(12) << "ms/frame" << "\n";
+
+    for (const auto& size : blockSizes) {
+        for (const auto& c : cases) {
+            AsciiConverter converter;
+            converter.setConversionMode(c.mode);
+            converter.setScaleFilter(c.filter);
+            if (converter.init(width, height, AV_PIX_FMT_YUV420P, size[0], size[1]) < 0) {
+                std::cerr << "init failed for " << c.name << "\n";
+                continue;
+            }
+
+            AsciiGrid grid;
+            grid.resize(converter.getGridRows(), converter.getGridCols());
+
+            converter.convert(frame, grid); // warm-up
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                converter.convert(frame, grid);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+            std::cout << std::left << std::setw(8) << (std::to_string(size[0]) + "x" + std::to_string(size[1]))
+                      << std::setw(16) << c.name << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(12) << ms << "\n";
+        }
+    }
+
+    av_frame_free(&frame);
+    return 0;
+}
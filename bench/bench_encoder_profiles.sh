@@ -0,0 +1,38 @@
+#!/bin/sh
+# Encodes a reference clip once per encoder profile and prints a markdown table of
+# throughput and output size.
+#
+# usage: bench/bench_encoder_profiles.sh <clip> [binary] [max-frames]
+#   binary defaults to ./build/AsciiVideoFilter, max-frames to 300 (-1 for the whole clip)
+#
+# Needs ffprobe on PATH to count the frames actually written.
+#
+# No results have been recorded yet; the profile descriptions (fastest, smallest) follow the
+# x264 presets they use rather than measurements from this tool.
+
+set -eu
+
+clip=${1:?usage: $0 <clip> [binary] [max-frames]}
+binary=${2:-./build/AsciiVideoFilter}
+maxFrames=${3:-300}
+outDir=$(mktemp -d)
+trap 'rm -rf "$outDir"' EXIT
+
+echo "Clip: $clip, max frames: $maxFrames, $(nproc) cores"
+echo
+echo "| profile    | frames | seconds | fps    | size (KiB) |"
+echo "|------------|--------|---------|--------|------------|"
+
+for profile in throughput balanced archival; do
+    out="$outDir/$profile.mp4"
+    start=$(date +%s.%N)
+    "$binary" -i "$clip" -o "$out" --encoder-profile "$profile" --max-frames "$maxFrames" \
+        --no-audio --no-progress > /dev/null 2>&1
+    end=$(date +%s.%N)
+
+    frames=$(ffprobe -v error -select_streams v:0 -count_packets \
+        -show_entries stream=nb_read_packets -of csv=p=0 "$out")
+    size=$(( $(wc -c < "$out") / 1024 ))
+    awk -v p="$profile" -v f="$frames" -v s="$start" -v e="$end" -v k="$size" \
+        'BEGIN { t = e - s; printf "| %-10s | %6d | %7.2f | %6.1f | %10d |\n", p, f, t, f / t, k }'
+done
@@ -3,18 +3,37 @@
 #include "VideoEncoder.hpp"
 #include "AsciiConverter.hpp"
 #include "AsciiRenderer.hpp"
+#include "GridReader.hpp"
+#include "GridWriter.hpp"
+#include "Pipeline.hpp"
+#include "SegmentConcatenator.hpp"
+#include "Stats.hpp"
+#include "TerminalSink.hpp"
 #include "Utils.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <libavutil/log.h>
 #include <string>
 #include <unordered_map>
 #include <iostream>
+#include <limits>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
 
 extern "C" {
     #include <libavutil/frame.h>
     #include <libavcodec/packet.h>
+    #include <libavutil/mathematics.h>
 }
 
 namespace AsciiVideoFilter {
@@ -22,13 +41,42 @@ namespace AsciiVideoFilter {
 Application::Application() {}
 Application::~Application() {}
 
+// --stats-json and --trace reports, written once every stage has stopped
+static void writeReports(const std::string& statsJsonPath, const std::string& tracePath, int64_t frameCount, double wallSeconds) {
+    if (!statsJsonPath.empty() && Stats::writeJson(statsJsonPath, frameCount, wallSeconds) == 0) {
+        std::cout << "Stats written to " << statsJsonPath << "\n";
+    }
+    if (!tracePath.empty() && Stats::writeTrace(tracePath) == 0) {
+        std::cout << "Trace written to " << tracePath << " (open in chrome://tracing or ui.perfetto.dev)\n";
+    }
+}
+
+// Points std::cout at stderr while alive, if asked to
+class StdoutToStderr {
+public:
+    explicit StdoutToStderr(bool redirect)
+        : m_saved(redirect ? std::cout.rdbuf(std::cerr.rdbuf()) : nullptr)
+    {}
+
+    ~StdoutToStderr() {
+        if (m_saved) {
+            std::cout.rdbuf(m_saved);
+        }
+    }
+
+private:
+    std::streambuf* m_saved;
+};
+
 int Application::run(int argc, const char *argv[]) {
     // TODO: Better argument parsing. Current one very rudimentary
     // TODO: AppErrorCodes aren't setup right in recent parts of the codebase. Fix soon
-    // TODO: Actual Multithreaded Pipeline.
 
     AppConfig config = Utils::parseArguments(argc, argv);
 
+    // With the video on stdout, everything printed for the user (progress included) goes to stderr
+    StdoutToStderr stdoutGuard(config.outputPath == "-");
+
     av_log_set_level(AV_LOG_PANIC);
 
     if(config.verbose) {
@@ -39,6 +87,14 @@ int Application::run(int argc, const char *argv[]) {
         #endif // DEBUG
     }
 
+    if (config.segments > 1 && config.segmentIndex < 0) {
+        return runSegmented(config, argc, argv);
+    }
+
+    if (!config.fromGridPath.empty()) {
+        return runFromGrid(config);
+    }
+
     const std::unordered_map<std::string, std::string> charPresets = {
         {"standard", " .:-=+*#%@"},
         {"detailed", " .'`^,:;Il!i><~+_-?][}{1)(|\\/tfjrxnumbroCLJVUNYXOZmwqpdbkhao*#MW&8%B@$"},
@@ -53,29 +109,127 @@ int Application::run(int argc, const char *argv[]) {
                         config.customCharset;
 
 
+    const std::unordered_map<std::string, int> decodeThreadTypes = {
+        {"auto", FF_THREAD_FRAME | FF_THREAD_SLICE},
+        {"frame", FF_THREAD_FRAME},
+        {"slice", FF_THREAD_SLICE}
+    };
+
     VideoDecoder decoder;
+    decoder.setThreading(config.decodeThreads, decodeThreadTypes.at(config.decodeThreadType));
+    decoder.setExportMotionVectors(config.motionSkip);
+    decoder.setStreamOptions(config.probeSize, config.analyzeDuration, static_cast<size_t>(config.readAheadMiB) << 20);
     if (decoder.open(config.inputPath) < 0) {
         std::cerr << "Failed to open input video.\n";
         return 1;
     }
 
+    // A segment worker only handles its own keyframe-aligned slice, written to its part file without
+    // audio; the coordinator remuxes audio once when it joins the parts
+    std::string outputPath = config.outputPath;
+    if (config.segmentIndex >= 0) {
+        std::vector<int64_t> boundaries;
+        if (decoder.findSegmentBoundaries(config.segments, boundaries) < 0 ||
+            decoder.setPtsRange(boundaries[config.segmentIndex], boundaries[config.segmentIndex + 1]) < 0) {
+            std::cerr << "Failed to locate segment " << config.segmentIndex << " of " << config.segments << ".\n";
+            return 1;
+        }
+        outputPath = Utils::segmentPath(config.outputPath, config.segmentIndex);
+    }
+
+    // Workers share the command line, so each one reports to its own files
+    std::string statsJsonPath = config.statsJsonPath;
+    std::string tracePath = config.tracePath;
+    if (config.segmentIndex >= 0) {
+        const std::string suffix = ".part" + std::to_string(config.segmentIndex);
+        statsJsonPath += statsJsonPath.empty() ? "" : suffix;
+        tracePath += tracePath.empty() ? "" : suffix;
+    }
+    Stats::setEnabled(!statsJsonPath.empty());
+    Stats::setTracing(!tracePath.empty());
+    Stats::setThreadName("main");
+
+    // --start/--end: seek to the keyframe before the start instead of decoding everything up to it
+    const bool timeRange = config.startSeconds > 0.0 || config.endSeconds >= 0.0;
+    if (timeRange && decoder.setTimeRange(config.startSeconds, config.endSeconds) < 0) {
+        std::cerr << "Failed to seek to the start time.\n";
+        return 1;
+    }
+
     int videoWidth = decoder.getWidth();
     int videoHeight = decoder.getHeight();
     double frameRate = decoder.getMetadata().getFps();
 
-    int64_t totalFrames = config.maxFrames == -1 ? decoder.getMetadata().getTotalFrames() :
-                     std::min<int64_t>(config.maxFrames, decoder.getMetadata().getTotalFrames());
+    int64_t rangeFrames = decoder.getMetadata().getTotalFrames();
+    if (timeRange) {
+        // Streams often have no known duration (0)
+        const double durationSeconds = decoder.getMetadata().durationSeconds;
+        const double rangeEnd = config.endSeconds < 0.0 ? durationSeconds :
+                                durationSeconds > 0.0 ? std::min(config.endSeconds, durationSeconds) : config.endSeconds;
+        rangeFrames = static_cast<int64_t>(std::max(0.0, rangeEnd - config.startSeconds) * frameRate);
+    }
+    int64_t totalFrames = config.maxFrames == -1 ? rangeFrames : std::min<int64_t>(config.maxFrames, rangeFrames);
 
-    ProgressTracker progress(totalFrames, frameRate, config.progressInterval, config.showProgress);
+    // The progress bar would draw over the picture in terminal playback
+    ProgressTracker progress(totalFrames, frameRate, config.progressInterval,
+                             config.showProgress && config.terminalColour.empty());
+
+    const std::unordered_map<std::string, ConversionMode> conversionModes = {
+        {"rgb", ConversionMode::RGB},
+        {"yuv", ConversionMode::YUV},
+        {"scale", ConversionMode::SCALE}
+    };
+    const std::unordered_map<std::string, int> scaleFilters = {
+        {"area", SWS_AREA},
+        {"bilinear", SWS_BILINEAR},
+        {"bicubic", SWS_BICUBIC},
+        {"fast_bilinear", SWS_FAST_BILINEAR},
+        {"point", SWS_POINT},
+        {"gauss", SWS_GAUSS},
+        {"lanczos", SWS_LANCZOS},
+        {"spline", SWS_SPLINE}
+    };
 
     AsciiConverter converter;
     converter.setAsciiCharset(charset);
+    converter.setConversionMode(conversionModes.at(config.convertMode));
+    converter.setScaleFilter(scaleFilters.at(config.scaleFilter));
+    converter.setMotionSkip(config.motionSkip);
+    converter.setReorderDelay(decoder.getReorderDelay());
+    converter.setReferenceFrames(decoder.getReferenceFrames());
+    if (config.motionSkip && (decoder.getReorderDelay() > 0 || decoder.getReferenceFrames() != 1)) {
+        std::cerr << "Warning: --motion-skip needs a stream without B-frames and with one reference frame (reorder delay "
+                  << decoder.getReorderDelay() << ", reference frames " << decoder.getReferenceFrames()
+                  << ", 0 = unknown); every frame is converted in full.\n";
+    }
+    converter.setThreadCount(config.convertThreads);
     converter.init(videoWidth, videoHeight, decoder.getPixelFormat(), config.blockWidth, config.blockHeight);
 
-    AVFrame* inFrame = av_frame_alloc();
-    if (!inFrame) {
-        std::cerr << "Failed to allocate input frame.\n";
-        return 1;
+    if (!config.terminalColour.empty()) {
+        const auto playStart = std::chrono::steady_clock::now();
+        const int64_t frameCount = playTerminal(config, decoder, converter);
+        if (frameCount < 0) {
+            return 1;
+        }
+        writeReports(statsJsonPath, tracePath, frameCount,
+                     std::chrono::duration<double>(std::chrono::steady_clock::now() - playStart).count());
+        LOG("End\n");
+        return 0;
+    }
+
+    if (Utils::isGridPath(outputPath)) {
+        if (config.enableAudio && decoder.hasAudio()) {
+            std::cout << "Audio is not stored in .agrid output.\n";
+        }
+        const auto exportStart = std::chrono::steady_clock::now();
+        const int64_t frameCount = exportGrids(config, decoder, converter, progress, outputPath);
+        if (frameCount < 0) {
+            return 1;
+        }
+        writeReports(statsJsonPath, tracePath, frameCount,
+                     std::chrono::duration<double>(std::chrono::steady_clock::now() - exportStart).count());
+        LOG("End\n");
+        return 0;
     }
 
     AsciiRenderer renderer;
@@ -85,87 +239,437 @@ int Application::run(int argc, const char *argv[]) {
         return static_cast<int>(AppErrorCode::APP_ERR_FONT_INIT_FAILED); 
     }
 
+    renderer.setOutputFormat(config.renderFormat == "yuv" ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_RGB24);
+    renderer.setThreadCount(config.renderThreads);
     renderer.initFrame(videoWidth, videoHeight, converter.getBlockWidth(), converter.getBlockHeight());
 
+    EncoderProfile encoderProfile = *EncoderProfiles::find(config.encoderProfile);
+    if (config.encoderThreads >= 0) {
+        encoderProfile.threads = config.encoderThreads;
+    }
+
+    ContainerFormat container = ContainerFormat::MP4;
+    VideoEncoder::parseContainer(config.container, outputPath, container);
+
     VideoEncoder encoder;
-    if (encoder.init(config.outputPath, decoder.getMetadata(), videoWidth, videoHeight, 400000) < 0) {
+    encoder.setContainer(container);
+    if (encoder.init(outputPath, decoder.getMetadata(), videoWidth, videoHeight, encoderProfile) < 0) {
         std::cerr << "Failed to initialize video encoder.\n";
         return 1;
     }
 
-    if (config.enableAudio && decoder.hasAudio()) {
-        encoder.addAudioStreamFrom(decoder.getAudioStream());
+    // Audio is remuxed during the video demux pass: the decoder hands every audio packet it meets
+    // straight to the muxer instead of reading the input a second time.
+    int64_t audioPacketCount = 0;
+    if (config.enableAudio && decoder.hasAudio() && config.segmentIndex < 0) {
+        if (encoder.addAudioStreamFrom(decoder.getAudioStream()) == 0) {
+            // With --start/--end, keep the audio packets that start inside the range and shift them
+            // so the range start lines up with the first video frame at pts 0
+            const AVRational audioTimeBase = decoder.getAudioStream()->time_base;
+            const int64_t audioStart = decoder.getRangeStart() == std::numeric_limits<int64_t>::min() ? 0 :
+                                       av_rescale_q(decoder.getRangeStart(), decoder.getTimeBase(), audioTimeBase);
+            const int64_t audioEnd = decoder.getRangeEnd() == std::numeric_limits<int64_t>::max() ? std::numeric_limits<int64_t>::max() :
+                                     av_rescale_q(decoder.getRangeEnd(), decoder.getTimeBase(), audioTimeBase);
+            decoder.setAudioPacketHandler([&, audioStart, audioEnd](AVPacket* pkt) {
+                Stats::ScopedTimer timer(Stage::AudioRemux);
+                if (timeRange && pkt->pts != AV_NOPTS_VALUE) {
+                    if (pkt->pts < audioStart || pkt->pts >= audioEnd) {
+                        return 0;
+                    }
+                    pkt->pts -= audioStart;
+                    if (pkt->dts != AV_NOPTS_VALUE) {
+                        pkt->dts -= audioStart;
+                    }
+                }
+                if (config.verbose) {
+                    LOG("Audio Packet Loop Counter: %" PRId64 ", PTS: %" PRId64 ", DTS: %" PRId64 ", Duration: %" PRId64 ", Stream Index: %d\n",
+                        audioPacketCount, pkt->pts, pkt->dts, pkt->duration, pkt->stream_index);
+                }
+                audioPacketCount++;
+                return encoder.writeAudioPacket(pkt);
+            });
+        } else {
+            std::cerr << "Failed to add audio stream. Continuing without audio.\n";
+        }
+    } else if (!decoder.hasAudio()) {
+        std::cout << "No audio stream to remux.\n";
     }
 
-    AsciiGrid grid;
-    grid.cols = converter.getGridCols();
-    grid.rows = converter.getGridRows();
-    grid.chars.assign(grid.rows, std::vector<char>(grid.cols));
-    grid.colours.assign(grid.rows, std::vector<RGB>(grid.cols));
+    Pipeline pipeline(decoder, converter, renderer, encoder, config);
+    const auto pipelineStart = std::chrono::steady_clock::now();
+    int64_t frameCount = pipeline.run(progress);
+    #ifdef DEBUG
+        const double pipelineSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - pipelineStart).count();
+    #endif // DEBUG
+    if (frameCount < 0) {
+        std::cerr << "Failed to start processing pipeline.\n";
+        return 1;
+    }
 
-    int64_t frameCount = 0;
-    while (decoder.readFrame(inFrame) && (config.maxFrames == -1 || frameCount < config.maxFrames)) {
-        converter.convert(inFrame, grid);
+    encoder.finalize();
+    progress.finish();
+
+    // Wall time includes the encoder flush, whose packets are among the mux samples
+    writeReports(statsJsonPath, tracePath, frameCount,
+                 std::chrono::duration<double>(std::chrono::steady_clock::now() - pipelineStart).count());
+
+    if(config.verbose) {
+        LOG("Video stream rendered and encoded..\n");
+        LOG("Audio stream remuxed into output file (%" PRId64 " packets).\n", audioPacketCount);
+        // Near 100% means decoding is what limits throughput
+        LOG("Decode thread utilisation: %.1f%% (%.2fs in readFrame over %.2fs, %d decoder threads)\n",
+            pipelineSeconds > 0 ? decoder.getDecodeSeconds() / pipelineSeconds * 100.0 : 0.0,
+            decoder.getDecodeSeconds(), pipelineSeconds, decoder.getThreadCount());
+        if (decoder.getReadAheadCapacity() > 0) {
+            // A full buffer means the source was waiting on us, an empty one that we waited on it
+            LOG("Read-ahead buffer peaked at %.2f of %.2f MiB.\n",
+                decoder.getReadAheadPeak() / 1048576.0, decoder.getReadAheadCapacity() / 1048576.0);
+        }
+        if (config.dedupe) {
+            LOG("Skipped %" PRId64 " repeated frames of %" PRId64 ".\n", pipeline.getRepeatedFrames(), frameCount);
+        }
+        if (config.pipeline) {
+            // created well above queueDepth + 2 would mean a stage is allocating per frame
+            #ifdef DEBUG
+                const PoolStats decoded = pipeline.getDecodedPoolStats();
+                const PoolStats grids = pipeline.getGridPoolStats();
+                const PoolStats rendered = pipeline.getRenderedPoolStats();
+                LOG("Pools (created / peak in use): decoded frames %zu / %zu, grids %zu / %zu, rendered frames %zu / %zu\n",
+                    decoded.created, decoded.peakInUse, grids.created, grids.peakInUse, rendered.created, rendered.peakInUse);
+            #endif // DEBUG
+        }
+        LOG("Converter recomputed %.1f%% of cells per frame on average (%d bands on %d convert threads).\n",
+            converter.getAverageRecomputedFraction() * 100.0, converter.getBandCount(), converter.getThreadCount());
+        LOG("Renderer redrew %.1f%% of cells per frame on average (%d render threads).\n",
+            renderer.getAverageRedrawFraction() * 100.0, renderer.getThreadCount());
+    }
+    LOG("End\n");
+    return 0;
+}
+
+int Application::runFromGrid(const AppConfig& config) {
+    Stats::setEnabled(!config.statsJsonPath.empty());
+    Stats::setTracing(!config.tracePath.empty());
+    Stats::setThreadName("main");
+
+    GridReader reader;
+    if (reader.open(config.fromGridPath) < 0) {
+        std::cerr << "Failed to open grid input.\n";
+        return 1;
+    }
+    if (config.enableColour && !reader.hasColour()) {
+        std::cout << "Grid file has no colours, rendering in white.\n";
+    }
+
+    const AVRational frameRate = reader.getFrameRate();
+    const double fps = av_q2d(frameRate);
+    if (fps <= 0.0) {
+        std::cerr << "Grid file has an invalid frame rate.\n";
+        return 1;
+    }
+
+    // --start/--end pick frames through the index; nothing before the start is rendered
+    int64_t firstFrame = 0;
+    int64_t endFrame = reader.getFrameCount();
+    if (config.startSeconds > 0.0) {
+        firstFrame = reader.findFrame(std::llround(config.startSeconds * fps));
+    }
+    if (config.endSeconds >= 0.0) {
+        endFrame = std::min(endFrame, reader.findFrame(std::llround(config.endSeconds * fps)));
+    }
+    if (config.maxFrames != -1) {
+        endFrame = std::min(endFrame, firstFrame + config.maxFrames);
+    }
+    const int64_t totalFrames = std::max<int64_t>(0, endFrame - firstFrame);
+    const int64_t startPts = firstFrame < reader.getFrameCount() ? reader.getPts(firstFrame) : 0;
+
+    if (!config.terminalColour.empty()) {
+        TerminalColour colour = TerminalColour::NONE;
+        if (config.enableColour) {
+            TerminalSink::parseColour(config.terminalColour, colour);
+        }
+        TerminalSink sink;
+        if (sink.init(reader.getRows(), reader.getCols(), colour, av_inv_q(frameRate), frameRate) < 0) {
+            std::cerr << "Failed to set up terminal playback.\n";
+            return 1;
+        }
+        const auto playStart = std::chrono::steady_clock::now();
+        int64_t frameCount = 0;
+        for (int64_t frame = firstFrame; frame < endFrame; ++frame) {
+            // Late grids aren't even decoded; the next readFrame() applies the deltas in between
+            if (sink.isLate(reader.getPts(frame))) {
+                sink.dropFrame();
+                continue;
+            }
+            if (reader.readFrame(frame) < 0 || sink.writeFrame(reader.getGrid(), reader.getPts(frame)) < 0) {
+                break;
+            }
+            frameCount++;
+        }
+        sink.finish();
+        std::cout << "Played " << sink.getShownFrames() << " frames, dropped " << sink.getDroppedFrames() << ".\n";
+        writeReports(config.statsJsonPath, config.tracePath, frameCount,
+                     std::chrono::duration<double>(std::chrono::steady_clock::now() - playStart).count());
+        return 0;
+    }
+
+    // The cell layout is fixed by the file; the block size only decides how large each cell is drawn.
+    // x264 needs even dimensions, any extra column or row stays black.
+    const int width = (reader.getCols() * config.blockWidth + 1) & ~1;
+    const int height = (reader.getRows() * config.blockHeight + 1) & ~1;
 
-        AVFrame* renderedFrame = renderer.render(grid, config.enableColour);
-        if (!renderedFrame) {
-            std::cerr << "Rendering failed.\n";
+    AsciiRenderer renderer;
+    if (renderer.initFont(config.fontPath, config.blockHeight) < 0) {
+        std::cerr << "Error: Failed to initialize ASCII renderer font. Exiting.\n";
+        return static_cast<int>(AppErrorCode::APP_ERR_FONT_INIT_FAILED);
+    }
+    renderer.setOutputFormat(config.renderFormat == "yuv" ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_RGB24);
+    renderer.setThreadCount(config.renderThreads);
+    if (renderer.initFrame(width, height, config.blockWidth, config.blockHeight) < 0) {
+        std::cerr << "Failed to initialize ASCII renderer.\n";
+        return 1;
+    }
+
+    EncoderProfile encoderProfile = *EncoderProfiles::find(config.encoderProfile);
+    if (config.encoderThreads >= 0) {
+        encoderProfile.threads = config.encoderThreads;
+    }
+
+    VideoMetadata metadata;
+    metadata.width = width;
+    metadata.height = height;
+    metadata.frameRate = frameRate;
+    metadata.timeBase = av_inv_q(frameRate);
+    metadata.durationSeconds = totalFrames / fps;
+    metadata.duration = totalFrames;
+
+    ContainerFormat container = ContainerFormat::MP4;
+    VideoEncoder::parseContainer(config.container, config.outputPath, container);
+
+    VideoEncoder encoder;
+    encoder.setContainer(container);
+    if (encoder.init(config.outputPath, metadata, width, height, encoderProfile) < 0) {
+        std::cerr << "Failed to initialize video encoder.\n";
+        return 1;
+    }
+
+    ProgressTracker progress(totalFrames, fps, config.progressInterval, config.showProgress);
+    const auto renderStart = std::chrono::steady_clock::now();
+
+    int64_t frameCount = 0;
+    for (int64_t frame = firstFrame; frame < endFrame; ++frame) {
+        if (reader.readFrame(frame) < 0) {
+            std::cerr << "Failed to read grid " << frame << ", stopping.\n";
             break;
         }
+        AVFrame* rendered = renderer.render(reader.getGrid(), config.enableColour);
+        if (!rendered || encoder.encodeFrame(rendered, reader.getPts(frame) - startPts) < 0) {
+            std::cerr << "Failed to render or encode grid " << frame << ", stopping.\n";
+            break;
+        }
+        progress.update(frameCount++);
+    }
 
-        if (encoder.encodeFrame(renderedFrame) < 0) {
-            std::cerr << "Encoding frame failed.\n";
+    encoder.finalize();
+    progress.finish();
+    std::cout << "Re-render completed. Total frames: " << frameCount << "\n";
+
+    writeReports(config.statsJsonPath, config.tracePath, frameCount,
+                 std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count());
+
+    if (config.verbose) {
+        LOG("Rendered %" PRId64 " stored grids of %dx%d cells at %dx%d.\n",
+            frameCount, reader.getCols(), reader.getRows(), width, height);
+        LOG("Renderer redrew %.1f%% of cells per frame on average (%d render threads).\n",
+            renderer.getAverageRedrawFraction() * 100.0, renderer.getThreadCount());
+    }
+    LOG("End\n");
+    return frameCount == totalFrames ? 0 : 1;
+}
+
+int64_t Application::playTerminal(const AppConfig& config, VideoDecoder& decoder, AsciiConverter& converter) {
+    TerminalColour colour = TerminalColour::NONE;
+    if (config.enableColour) {
+        TerminalSink::parseColour(config.terminalColour, colour);
+    }
+
+    TerminalSink sink;
+    if (sink.init(converter.getGridRows(), converter.getGridCols(), colour, decoder.getTimeBase(),
+                  decoder.getMetadata().frameRate) < 0) {
+        std::cerr << "Failed to set up terminal playback.\n";
+        return -1;
+    }
+
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) {
+        std::cerr << "Failed to allocate input frame.\n";
+        return AVERROR(ENOMEM);
+    }
+    AsciiGrid grid;
+    grid.resize(converter.getGridRows(), converter.getGridCols());
+
+    // Motion skip reuses the previous frame's cells, so with it every frame has to be converted
+    const bool skipLate = !config.motionSkip;
+    int64_t frameCount = 0;
+    bool failed = false;
+    while ((config.maxFrames == -1 || frameCount < config.maxFrames) && decoder.readFrame(frame)) {
+        const int64_t pts = frame->best_effort_timestamp;
+        frameCount++;
+        if (skipLate && sink.isLate(pts)) {
+            sink.dropFrame();
+            av_frame_unref(frame);
+            continue;
+        }
+        converter.convert(frame, grid, config.enableColour);
+        av_frame_unref(frame);
+        if (sink.writeFrame(grid, pts) < 0) {
+            failed = true;
             break;
         }
-        av_frame_unref(inFrame);
+    }
+    av_frame_free(&frame);
+    sink.finish();
 
-        progress.update(frameCount++);
+    if (failed) {
+        return -1;
+    }
+    std::cout << "Played " << sink.getShownFrames() << " frames, dropped " << sink.getDroppedFrames() << ".\n";
+    if (config.verbose) {
+        LOG("Wrote %" PRIu64 " bytes to the terminal, %.1f per frame shown (%dx%d cells visible).\n",
+            sink.getBytesWritten(),
+            sink.getShownFrames() > 0 ? static_cast<double>(sink.getBytesWritten()) / sink.getShownFrames() : 0.0,
+            sink.getVisibleCols(), sink.getVisibleRows());
     }
-    av_frame_free(&inFrame);
+    return frameCount;
+}
 
+int64_t Application::exportGrids(const AppConfig& config, VideoDecoder& decoder, AsciiConverter& converter,
+                                 ProgressTracker& progress, const std::string& outputPath) {
+    GridWriter writer;
+    if (writer.open(outputPath, converter.getGridRows(), converter.getGridCols(),
+                    decoder.getMetadata().frameRate, config.enableColour) < 0) {
+        std::cerr << "Failed to create grid output.\n";
+        writer.close();
+        return -1;
+    }
 
-    encoder.finalize();
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) {
+        std::cerr << "Failed to allocate input frame.\n";
+        writer.close();
+        return AVERROR(ENOMEM);
+    }
+    AsciiGrid grid;
+    grid.resize(converter.getGridRows(), converter.getGridCols());
+
+    int64_t frameCount = 0;
+    bool failed = false;
+    while ((config.maxFrames == -1 || frameCount < config.maxFrames) && decoder.readFrame(frame)) {
+        converter.convert(frame, grid, config.enableColour);
+        av_frame_unref(frame);
+        if (writer.writeFrame(grid, frameCount) < 0) {
+            failed = true;
+            break;
+        }
+        progress.update(frameCount++);
+    }
+    av_frame_free(&frame);
+
+    if (writer.close() < 0 || failed) {
+        std::cerr << "Failed to write grid output.\n";
+        return -1;
+    }
     progress.finish();
+    std::cout << "Grid export completed. Total frames: " << frameCount << "\n";
 
-    if(config.verbose) {
-        LOG("Video stream rendered and encoded..\n");
+    if (config.verbose) {
+        LOG("Wrote %" PRId64 " grids (%" PRId64 " key frames) in %" PRIu64 " bytes, %.1f bytes per frame.\n",
+            writer.getFrameCount(), writer.getKeyframeCount(), writer.getBytesWritten(),
+            frameCount > 0 ? static_cast<double>(writer.getBytesWritten()) / frameCount : 0.0);
+        LOG("Converter recomputed %.1f%% of cells per frame on average (%d bands on %d convert threads).\n",
+            converter.getAverageRecomputedFraction() * 100.0, converter.getBandCount(), converter.getThreadCount());
     }
+    return frameCount;
+}
 
-    int64_t count = 0;
-    // remux the audio stream if exists
-    if(config.verbose) {
-        std::cout<< "Remuxxing audio stream.\n";
+int Application::runSegmented(const AppConfig& config, int argc, const char* argv[]) {
+    // Work out the split the same way every worker will, to know which segments are non-empty
+    std::vector<int64_t> boundaries;
+    {
+        VideoDecoder probe;
+        if (probe.open(config.inputPath) < 0 || probe.findSegmentBoundaries(config.segments, boundaries) < 0) {
+            std::cerr << "Failed to split input into segments.\n";
+            return 1;
+        }
+    }
+    std::vector<int> segments;
+    for (int i = 0; i < config.segments; ++i) {
+        if (boundaries[i] < boundaries[i + 1]) {
+            segments.push_back(i);
+        }
+    }
+    if (static_cast<int>(segments.size()) < config.segments) {
+        std::cout << "Input has too few keyframes for " << config.segments << " segments, using " << segments.size() << ".\n";
     }
-    if (decoder.hasAudio()) {
-        AVPacket* pkt = av_packet_alloc();
-        if (!pkt) {
-            std::cerr << "Failed to allocate audio packet.\n";
-            return static_cast<int>(AppErrorCode::APP_ERR_AUDIO_PKT_ALLOC_FAILED);
-        } else {
-            // Loop for audio packets
-            while (decoder.readNextAudioPacket(pkt)) {
-                if(config.verbose) {
-                    LOG("Audio Packet Loop Counter: %d, PTS: %lld, DTS: %lld, Duration: %lld, Stream Index: %d\n",
-                        count, pkt->pts, pkt->dts, pkt->duration, pkt->stream_index);
-                }
 
-                if (encoder.writeAudioPacket(pkt) < 0) {
-                    std::cerr << "Error writing audio packet. Stopping audio remux.\n";
-                    av_packet_unref(pkt);
-                    break;
-                }
-                av_packet_unref(pkt); // Unreference packet after successful write
-                count++;
+    if (!config.concatOnly) {
+        // Each worker is this program again with the same arguments plus its segment index
+        std::vector<std::string> indexArgs;
+        std::vector<pid_t> workers;
+        bool spawnFailed = false;
+        for (int index : segments) {
+            std::string indexArg = std::to_string(index);
+            std::vector<char*> workerArgv;
+            for (int i = 0; i < argc; ++i) {
+                workerArgv.push_back(const_cast<char*>(argv[i]));
+            }
+            workerArgv.push_back(const_cast<char*>("--segment-index"));
+            workerArgv.push_back(indexArg.data());
+            workerArgv.push_back(const_cast<char*>("--no-progress"));
+            workerArgv.push_back(nullptr);
+
+            pid_t pid;
+            int ret = posix_spawn(&pid, "/proc/self/exe", nullptr, nullptr, workerArgv.data(), environ);
+            if (ret != 0) {
+                ret = posix_spawnp(&pid, argv[0], nullptr, nullptr, workerArgv.data(), environ);
+            }
+            if (ret != 0) {
+                std::cerr << "Failed to start worker for segment " << index << ": " << std::strerror(ret) << "\n";
+                spawnFailed = true;
+                break;
             }
-            av_packet_free(&pkt); // Free the packet when done with the loop
+            workers.push_back(pid);
+        }
+
+        bool workersFailed = spawnFailed;
+        for (pid_t pid : workers) {
+            int status = 0;
+            if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                workersFailed = true;
+            }
+        }
+        if (workersFailed) {
+            std::cerr << "A segment worker failed; segment files were left in place.\n";
+            return 1;
         }
-    } else {
-        std::cout << "No audio stream to remux.\n";
     }
-    if(config.verbose) {
-        LOG("Audio Stream remuxxed into output file.\n");
+
+    std::vector<std::string> parts;
+    for (int index : segments) {
+        parts.push_back(Utils::segmentPath(config.outputPath, index));
     }
-    LOG("End\n");
+
+    SegmentConcatenator concatenator;
+    if (concatenator.concat(parts, config.enableAudio ? config.inputPath : "", config.outputPath) < 0) {
+        std::cerr << "Failed to join segments into " << config.outputPath << ".\n";
+        return 1;
+    }
+    for (const auto& part : parts) {
+        std::error_code ec;
+        std::filesystem::remove(part, ec);
+    }
+
+    std::cout << "Joined " << parts.size() << " segments into " << config.outputPath << "\n";
     return 0;
 }
 } // namespace AsciiVideoFilter
@@ -1,7 +1,15 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+
 namespace AsciiVideoFilter {
 
+struct AppConfig;
+class VideoDecoder;
+class AsciiConverter;
+class ProgressTracker;
+
 class Application {
 public:
     Application();
@@ -13,6 +21,22 @@ public:
 private:
     // Helper to print usage information
     void printUsage() const;
+
+    // --segments N: spawns one worker process per keyframe-aligned segment (or, with --concat-only,
+    // expects their part files to exist already) and joins the parts into the output
+    int runSegmented(const AppConfig& config, int argc, const char *argv[]);
+
+    // --from-grid: renders and encodes the grids of a .agrid file, skipping decode and conversion
+    int runFromGrid(const AppConfig& config);
+
+    // --terminal: decodes and converts every frame and plays the grids on the terminal with
+    // TerminalSink, paced to their pts. Returns the number of frames decoded, or a negative error code.
+    int64_t playTerminal(const AppConfig& config, VideoDecoder& decoder, AsciiConverter& converter);
+
+    // .agrid output: decodes and converts every frame and stores the grids with GridWriter, skipping
+    // the renderer and encoder. Returns the number of frames written, or a negative error code.
+    int64_t exportGrids(const AppConfig& config, VideoDecoder& decoder, AsciiConverter& converter,
+                        ProgressTracker& progress, const std::string& outputPath);
 };
 
 } // namespace AsciiVideoFilter
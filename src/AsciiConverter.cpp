@@ -1,8 +1,12 @@
 #include "AsciiConverter.hpp"
 #include "AsciiTypes.hpp"
+#include "Stats.hpp"
 #include "Utils.hpp" // AppErrorCode
 
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <iostream>
 #include <cmath>
 
@@ -10,6 +14,8 @@ extern "C" {
     #include <libswscale/swscale.h>
     #include <libavutil/avutil.h>
     #include <libavutil/error.h>
+    #include <libavutil/motion_vector.h>
+    #include <libavutil/pixdesc.h>
 }
 
 namespace AsciiVideoFilter {
@@ -22,6 +28,16 @@ AsciiConverter::AsciiConverter()
       m_srcHeight(0),
       m_blockWidth(0),
       m_blockHeight(0),
+      m_gridCols(0),
+      m_gridRows(0),
+      m_sumBlock(&BlockKernels::sumScalar),
+      m_kernelName("scalar"),
+      m_requestedMode(ConversionMode::RGB),
+      m_mode(ConversionMode::RGB),
+      m_chromaShiftX(0),
+      m_chromaShiftY(0),
+      m_fullRange(false),
+      m_scaleFilter(SWS_AREA),
       m_asciiChars(" .'`^,:;Il!i><~+_-?][}{1)(|\\/tfjrxnumbroCLJVUNYXOZmwqpdbkhao*#MW&8%B@$") // detailed character set
 {}
 
@@ -29,6 +45,46 @@ AsciiConverter::~AsciiConverter() {
     cleanup();
 }
 
+// True for 8-bit planar YUV with Y, U and V each in their own plane (yuv420p, yuv422p, yuvj444p, ...)
+static bool isPlanarYuv8(AVPixelFormat pixFmt) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(pixFmt);
+    if (!desc || desc->nb_components < 3) {
+        return false;
+    }
+    if (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM)) {
+        return false;
+    }
+    if (!(desc->flags & AV_PIX_FMT_FLAG_PLANAR)) {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        if (desc->comp[i].plane != i || desc->comp[i].depth != 8 || desc->comp[i].step != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sum of a width x height region of an 8-bit plane. Simple enough for the compiler to vectorize.
+static uint32_t sumPlane(const uint8_t* src, int stride, int width, int height) {
+    uint32_t sum = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = src + y * stride;
+        for (int x = 0; x < width; ++x) {
+            sum += row[x];
+        }
+    }
+    return sum;
+}
+
+static uint8_t clampToByte(float value) {
+    return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, value)));
+}
+
+static int64_t nanosecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
 void AsciiConverter::cleanup() {
     if (m_rgbBuffer) {
         av_free(m_rgbBuffer);
@@ -42,6 +98,68 @@ void AsciiConverter::cleanup() {
         sws_freeContext(m_swsContext);
         m_swsContext = nullptr;
     }
+    m_bands.clear();
+    for (Scratch& scratch : m_scratch) {
+        av_free(scratch.rgb);
+        sws_freeContext(scratch.fullBand);
+        sws_freeContext(scratch.lastBand);
+    }
+    m_scratch.clear();
+    m_threadPool.reset();
+}
+
+int AsciiConverter::initBands(AVPixelFormat srcPixFmt) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(srcPixFmt);
+    const int chromaRows = desc ? 1 << desc->log2_chroma_h : 1;
+    // Smallest number of block rows that spans whole chroma rows (1 unless the block height is odd)
+    int rowStep = 1;
+    while ((rowStep * m_blockHeight) % chromaRows != 0) {
+        rowStep++;
+    }
+
+    // Bands small enough that their RGB24 rows are still cached when the blocks are averaged,
+    // and enough of them to keep every thread busy
+    m_bandLinesize = (m_srcWidth * 3 + 31) & ~31;
+    const size_t blockRowBytes = static_cast<size_t>(m_bandLinesize) * m_blockHeight;
+    int rowsPerBand = std::max<int>(1, static_cast<int>(kBandBytes / blockRowBytes));
+    if (m_threadPool) {
+        const int tasks = getThreadCount() * kBandsPerThread;
+        rowsPerBand = std::min(rowsPerBand, (m_gridRows + tasks - 1) / tasks);
+    }
+    rowsPerBand = std::max(1, (rowsPerBand + rowStep - 1) / rowStep) * rowStep;
+    m_rowsPerBand = rowsPerBand;
+
+    for (int firstRow = 0; firstRow < m_gridRows; firstRow += rowsPerBand) {
+        m_bands.push_back(Band{firstRow, std::min(m_gridRows, firstRow + rowsPerBand)});
+    }
+    if (m_mode != ConversionMode::RGB) {
+        return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
+    }
+
+    const int lastRows = m_gridRows % rowsPerBand;
+    // SIMD block kernels read a few bytes past the last pixel of a row
+    const size_t bandBytes = blockRowBytes * rowsPerBand + BlockKernels::kReadPadding;
+    m_scratch.resize(getThreadCount());
+    for (Scratch& scratch : m_scratch) {
+        scratch.rgb = static_cast<uint8_t*>(av_malloc(bandBytes));
+        if (!scratch.rgb) {
+            std::cerr << "Error (AsciiConverter::initBands): Could not allocate band buffer: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, AVERROR(ENOMEM)) << "\n";
+            return AVERROR(ENOMEM);
+        }
+        const int fullHeight = rowsPerBand * m_blockHeight;
+        scratch.fullBand = sws_getContext(m_srcWidth, fullHeight, srcPixFmt, m_srcWidth, fullHeight, AV_PIX_FMT_RGB24,
+                                          SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (lastRows > 0) {
+            const int lastHeight = lastRows * m_blockHeight;
+            scratch.lastBand = sws_getContext(m_srcWidth, lastHeight, srcPixFmt, m_srcWidth, lastHeight, AV_PIX_FMT_RGB24,
+                                              SWS_BILINEAR, nullptr, nullptr, nullptr);
+        }
+        if (!scratch.fullBand || (lastRows > 0 && !scratch.lastBand)) {
+            std::cerr << "Error (AsciiConverter::initBands): Could not initialize SwsContext for ASCII conversion.\n";
+            return static_cast<int>(AppErrorCode::APP_ERR_CONVERTER_INIT_FAILED);
+        }
+    }
+    return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
 }
 
 int AsciiConverter::init(int src_width, int src_height, AVPixelFormat src_pix_fmt,
@@ -56,10 +174,70 @@ int AsciiConverter::init(int src_width, int src_height, AVPixelFormat src_pix_fm
     m_gridCols = src_width / m_blockWidth;
     m_gridRows = src_height / m_blockHeight;
 
+    m_previousValid = false;
+    m_reorderSeen = false;
+    m_cellDirty.assign(static_cast<size_t>(m_gridRows) * m_gridCols, 1);
+    m_cellCoverage.assign(static_cast<size_t>(m_gridRows) * m_gridCols, 0);
+
+    const BlockKernels::Kernel& kernel = BlockKernels::best();
+    m_sumBlock = kernel.fn;
+    m_kernelName = kernel.name;
+
+    m_mode = m_requestedMode;
+    if (m_mode == ConversionMode::YUV && !isPlanarYuv8(src_pix_fmt)) {
+        const char* name = av_get_pix_fmt_name(src_pix_fmt);
+        std::cerr << "Warning (AsciiConverter::init): YUV conversion needs 8-bit planar YUV, got "
+                  << (name ? name : "unknown") << ". Falling back to RGB.\n";
+        m_mode = ConversionMode::RGB;
+    }
+
+    if (m_mode != ConversionMode::SCALE) {
+        if (m_requestedThreads != 1) {
+            m_threadPool.reset(new ThreadPool(m_requestedThreads));
+            if (m_threadPool->getThreadCount() == 1) {
+                m_threadPool.reset();
+            }
+        }
+        const int ret = initBands(src_pix_fmt);
+        if (ret < 0) {
+            cleanup();
+            return ret;
+        }
+    }
+
+    if (m_mode == ConversionMode::YUV) {
+        // Blocks are read straight from the decoded planes; no RGB frame needed
+        av_pix_fmt_get_chroma_sub_sample(src_pix_fmt, &m_chromaShiftX, &m_chromaShiftY);
+        m_fullRange = src_pix_fmt == AV_PIX_FMT_YUVJ420P || src_pix_fmt == AV_PIX_FMT_YUVJ422P ||
+                      src_pix_fmt == AV_PIX_FMT_YUVJ444P;
+
+        std::cout << "AsciiConverter initialized. Source: " << m_srcWidth << "x" << m_srcHeight
+                  << ", ASCII Block: " << m_blockWidth << "x" << m_blockHeight
+                  << ", Mode: yuv (chroma 1/" << (1 << m_chromaShiftX) << "x1/" << (1 << m_chromaShiftY) << ")"
+                  << ", Bands: " << m_bands.size() << " on " << getThreadCount() << " thread(s)\n";
+        return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
+    }
+
+    if (m_mode == ConversionMode::RGB) {
+        // Each band is converted to RGB24 on its own in convert(); there is no full-size frame
+        std::cout << "AsciiConverter initialized. Source: " << m_srcWidth << "x" << m_srcHeight
+                  << ", ASCII Block: " << m_blockWidth << "x" << m_blockHeight
+                  << ", Mode: rgb, Kernel: " << m_kernelName
+                  << ", Bands: " << m_bands.size() << " on " << getThreadCount() << " thread(s)\n";
+        return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
+    }
+
+    // SCALE mode crops to the area the blocks cover (like the block loop does) and lets swscale
+    // box-filter it down to one pixel per cell.
+    const int rgbWidth = m_gridCols;
+    const int rgbHeight = m_gridRows;
+    const int swsSrcWidth = m_gridCols * m_blockWidth;
+    const int swsSrcHeight = m_gridRows * m_blockHeight;
+
     // Initialize SwsContext for converting to RGB24
-    m_swsContext = sws_getContext(m_srcWidth, m_srcHeight, src_pix_fmt,
-                                  m_srcWidth, m_srcHeight, AV_PIX_FMT_RGB24,
-                                  SWS_BILINEAR, nullptr, nullptr, nullptr);
+    m_swsContext = sws_getContext(swsSrcWidth, swsSrcHeight, src_pix_fmt,
+                                  rgbWidth, rgbHeight, AV_PIX_FMT_RGB24,
+                                  m_scaleFilter, nullptr, nullptr, nullptr);
     if (!m_swsContext) {
         std::cerr << "Error (AsciiConverter::init): Could not initialize SwsContext for ASCII conversion.\n";
         cleanup();
@@ -74,7 +252,7 @@ int AsciiConverter::init(int src_width, int src_height, AVPixelFormat src_pix_fm
         return AVERROR(ENOMEM);
     }
 
-    int num_bytes = av_image_get_buffer_size(AV_PIX_FMT_RGB24, m_srcWidth, m_srcHeight, 1);
+    int num_bytes = av_image_get_buffer_size(AV_PIX_FMT_RGB24, rgbWidth, rgbHeight, 1);
     m_rgbBuffer = (uint8_t *)av_malloc(num_bytes);
     if (!m_rgbBuffer) {
         std::cerr << "Error (AsciiConverter::init): Could not allocate image buffer for RGB frame: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, AVERROR(ENOMEM)) << "\n";
@@ -84,85 +262,339 @@ int AsciiConverter::init(int src_width, int src_height, AVPixelFormat src_pix_fm
 
     // RGB24 is a packed format. only data[0] (start of the buffer) and linesize[0] (i.e., srcWidth * 3) are used
     av_image_fill_arrays(m_rgbFrame->data, m_rgbFrame->linesize, m_rgbBuffer, AV_PIX_FMT_RGB24,
-                         m_srcWidth, m_srcHeight, 1);
-    m_rgbFrame->width = m_srcWidth;
-    m_rgbFrame->height = m_srcHeight;
+                         rgbWidth, rgbHeight, 1);
+    m_rgbFrame->width = rgbWidth;
+    m_rgbFrame->height = rgbHeight;
     m_rgbFrame->format = AV_PIX_FMT_RGB24;
 
     std::cout << "AsciiConverter initialized. Source: " << m_srcWidth << "x" << m_srcHeight
-              << ", ASCII Block: " << m_blockWidth << "x" << m_blockHeight << "\n";
+              << ", ASCII Block: " << m_blockWidth << "x" << m_blockHeight
+              << ", Mode: scale to " << rgbWidth << "x" << rgbHeight << "\n";
 
     return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS); 
 }
 
 void AsciiConverter::convert(AVFrame* decodedFrame, AsciiGrid &outGrid, bool enableColor) {
-
-    if (!m_swsContext || !m_rgbFrame || !decodedFrame) {
+    const bool ready = m_mode == ConversionMode::SCALE ? m_swsContext && m_rgbFrame
+                     : m_mode == ConversionMode::RGB ? !m_scratch.empty()
+                     : true;
+    if (!decodedFrame || m_blockWidth <= 0 || !ready) {
         std::cerr << "Error (AsciiConverter::convert): Not properly initialized.\n";
         return;
     }
+    Stats::ScopedTimer timer(Stage::Convert);
+
+    // Ensure outGrid has correct dimensions; reallocates only when the layout changes
+    if (outGrid.rows != m_gridRows || outGrid.cols != m_gridCols) {
+        outGrid.resize(m_gridRows, m_gridCols);
+    }
+
+    const int cells = m_gridRows * m_gridCols;
+    const uint8_t* dirty = nullptr;
+    int recomputed = cells;
+    if (m_motionSkip && m_mode != ConversionMode::SCALE) {
+        const int dirtyCells = buildDirtyMask(decodedFrame, enableColor);
+        if (dirtyCells >= 0) {
+            dirty = m_cellDirty.data();
+            recomputed = dirtyCells;
+        }
+    }
 
-    // Convert input frame to RGB24 format
-    sws_scale(m_swsContext, decodedFrame->data, decodedFrame->linesize, 0, decodedFrame->height,
-              m_rgbFrame->data, m_rgbFrame->linesize);
+    if (m_mode == ConversionMode::YUV) {
+        convertYuv(decodedFrame, outGrid, enableColor, dirty);
+    } else if (m_mode == ConversionMode::SCALE) {
+        convertScaled(decodedFrame, outGrid, enableColor);
+    } else {
+        convertRgb(decodedFrame, outGrid, enableColor, dirty);
+    }
+
+    m_cellsRecomputed += recomputed;
+    m_cellsConverted += cells;
+    if (m_motionSkip) {
+        // outGrid may be a fresh grid per frame (threaded pipeline), so keep our own copy
+        m_previousGrid = outGrid;
+        m_previousValid = true;
+        m_previousColour = enableColor;
+    }
+}
 
-    // Ensure outGrid has correct dimensions (extra assignment)
-    outGrid.cols = m_gridCols; 
-    outGrid.rows = m_gridRows;
+int AsciiConverter::buildDirtyMask(const AVFrame* decodedFrame, bool enableColour) {
+    // Zero vectors refer to a reference picture, and the vectors don't say which. Only with a single
+    // reference and no reordering is that the frame converted just before this one, whose cells
+    // m_previousGrid holds; with B-frames or several references a block may come from further back.
+    m_reorderSeen |= decodedFrame->pict_type == AV_PICTURE_TYPE_B;
+    if (!m_previousValid || m_previousColour != enableColour || decodedFrame->pict_type != AV_PICTURE_TYPE_P ||
+        m_reorderDelay > 0 || m_reorderSeen || m_referenceFrames != 1) {
+        return -1;
+    }
+    const AVFrameSideData* sideData = av_frame_get_side_data(decodedFrame, AV_FRAME_DATA_MOTION_VECTORS);
+    if (!sideData) {
+        return -1;
+    }
+    const AVMotionVector* vectors = reinterpret_cast<const AVMotionVector*>(sideData->data);
+    const size_t vectorCount = sideData->size / sizeof(AVMotionVector);
+
+    std::fill(m_cellDirty.begin(), m_cellDirty.end(), 0);
+    std::fill(m_cellCoverage.begin(), m_cellCoverage.end(), 0);
+    const int gridWidth = m_gridCols * m_blockWidth;
+    const int gridHeight = m_gridRows * m_blockHeight;
+
+    for (size_t i = 0; i < vectorCount; ++i) {
+        const AVMotionVector& mv = vectors[i];
+        // P frames only predict from the past (source -1); anything else leaves its cells uncovered
+        if (mv.source > 0) {
+            continue;
+        }
+        const bool moving = mv.motion_x != 0 || mv.motion_y != 0;
+
+        // dst_x/dst_y is the centre of the block in this frame
+        const int left = mv.dst_x - mv.w / 2;
+        const int top = mv.dst_y - mv.h / 2;
+        const int x0 = std::max(0, left);
+        const int y0 = std::max(0, top);
+        const int x1 = std::min(gridWidth, left + mv.w);
+        const int y1 = std::min(gridHeight, top + mv.h);
+        if (x0 >= x1 || y0 >= y1) {
+            continue;
+        }
+
+        for (int cellY = y0 / m_blockHeight; cellY <= (y1 - 1) / m_blockHeight; ++cellY) {
+            const int overlapY = std::min(y1, (cellY + 1) * m_blockHeight) - std::max(y0, cellY * m_blockHeight);
+            for (int cellX = x0 / m_blockWidth; cellX <= (x1 - 1) / m_blockWidth; ++cellX) {
+                const size_t cell = static_cast<size_t>(cellY) * m_gridCols + cellX;
+                if (moving) {
+                    m_cellDirty[cell] = 1;
+                } else {
+                    const int overlapX = std::min(x1, (cellX + 1) * m_blockWidth) - std::max(x0, cellX * m_blockWidth);
+                    m_cellCoverage[cell] += overlapX * overlapY;
+                }
+            }
+        }
+    }
+
+    // Whatever no zero-motion block fully covers was intra coded (or moved) and needs recomputing
+    const int blockPixels = m_blockWidth * m_blockHeight;
+    int dirtyCells = 0;
+    for (size_t cell = 0; cell < m_cellDirty.size(); ++cell) {
+        m_cellDirty[cell] |= m_cellCoverage[cell] < blockPixels;
+        dirtyCells += m_cellDirty[cell];
+    }
+    return dirtyCells;
+}
+
+void AsciiConverter::convertScaled(AVFrame* decodedFrame, AsciiGrid &outGrid, bool enableColor) {
+    {
+        // One pass over the cropped source height produces the whole gridCols x gridRows image
+        Stats::ScopedTimer timer(Stage::ConvertScale);
+        sws_scale(m_swsContext, decodedFrame->data, decodedFrame->linesize, 0, m_gridRows * m_blockHeight,
+                  m_rgbFrame->data, m_rgbFrame->linesize);
+    }
+    Stats::ScopedTimer timer(Stage::ConvertAverage);
+
+    for (int row = 0; row < outGrid.rows; ++row) {
+        const uint8_t* pixel = m_rgbFrame->data[0] + row * m_rgbFrame->linesize[0];
+        char* chars = outGrid.rowChars(row);
+        RGB* colours = outGrid.rowColours(row);
+        for (int col = 0; col < outGrid.cols; ++col, pixel += 3) {
+            const uint8_t r = pixel[0];
+            const uint8_t g = pixel[1];
+            const uint8_t b = pixel[2];
+
+            // Luminance of the filtered cell colour
+            chars[col] = charForBrightness((r * 299 + g * 587 + b * 114) / 1000);
+            colours[col] = enableColor ? RGB{r, g, b} : RGB{255, 255, 255};
+        }
+    }
+}
+
+void AsciiConverter::copyPreviousRows(int firstRow, int lastRow, AsciiGrid &outGrid) {
+    for (int row = firstRow; row < lastRow; ++row) {
+        std::copy_n(m_previousGrid.rowChars(row), outGrid.cols, outGrid.rowChars(row));
+        std::copy_n(m_previousGrid.rowColours(row), outGrid.cols, outGrid.rowColours(row));
+    }
+}
+
+// True if any cell of block rows [firstRow, lastRow) needs recomputing
+static bool anyDirty(const uint8_t* dirty, int firstRow, int lastRow, int cols) {
+    const uint8_t* begin = dirty + static_cast<size_t>(firstRow) * cols;
+    const uint8_t* end = dirty + static_cast<size_t>(lastRow) * cols;
+    return std::find(begin, end, 1) != end;
+}
+
+void AsciiConverter::convertRgb(AVFrame* decodedFrame, AsciiGrid &outGrid, bool enableColor, const uint8_t* dirty) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(decodedFrame->format));
+    const int chromaShiftY = desc ? desc->log2_chroma_h : 0;
+    const bool palette = desc && (desc->flags & AV_PIX_FMT_FLAG_PAL);
+    // Stage times are summed over the bands, whichever thread ran them
+    const bool timed = Stats::enabled();
+    std::atomic<int64_t> scaleNanoseconds{0};
+    std::atomic<int64_t> averageNanoseconds{0};
+
+    // Each band converts its own pixel rows into this thread's buffer and averages them straight
+    // away, while they are still in cache. Bands write disjoint grid rows. Every band is scaled on
+    // its own, which matches a whole-frame conversion for yuv420p; formats whose conversion
+    // interpolates chroma vertically can differ in the pixel rows next to a band edge.
+    auto convertBand = [&](int bandIndex, int thread) {
+        const Band& band = m_bands[bandIndex];
+        const Scratch& scratch = m_scratch[thread];
+        if (dirty && !anyDirty(dirty, band.firstRow, band.lastRow, m_gridCols)) {
+            copyPreviousRows(band.firstRow, band.lastRow, outGrid);
+            return;
+        }
+
+        const int y0 = band.firstRow * m_blockHeight;
+        const uint8_t* src[AV_NUM_DATA_POINTERS] = {};
+        for (int plane = 0; plane < AV_NUM_DATA_POINTERS && decodedFrame->data[plane]; ++plane) {
+            // Band starts are multiples of the chroma height, so chroma planes start on a whole row.
+            // A palette (data[1] of PAL8) is not an image plane and is passed as is.
+            const bool chroma = plane == 1 || plane == 2;
+            const int planeY = (palette && plane == 1) ? 0 : chroma ? y0 >> chromaShiftY : y0;
+            src[plane] = decodedFrame->data[plane] + static_cast<ptrdiff_t>(planeY) * decodedFrame->linesize[plane];
+        }
+
+        const int bandRows = band.lastRow - band.firstRow;
+        SwsContext* sws = bandRows == m_rowsPerBand ? scratch.fullBand : scratch.lastBand;
+        uint8_t* dst[4] = {scratch.rgb, nullptr, nullptr, nullptr};
+        const int dstLinesize[4] = {m_bandLinesize, 0, 0, 0};
+        const auto scaleStart = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        sws_scale(sws, src, decodedFrame->linesize, 0, bandRows * m_blockHeight, dst, dstLinesize);
+
+        const auto averageStart = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        convertRgbRows(scratch.rgb, m_bandLinesize, band.firstRow, band.lastRow, outGrid, enableColor, dirty);
+        if (timed) {
+            scaleNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(averageStart - scaleStart).count();
+            averageNanoseconds += nanosecondsSince(averageStart);
+        }
+    };
+    forEachBand(convertBand);
+
+    if (timed) {
+        Stats::record(Stage::ConvertScale, scaleNanoseconds);
+        Stats::record(Stage::ConvertAverage, averageNanoseconds);
+    }
+}
+
+void AsciiConverter::convertRgbRows(const uint8_t* rgb, int linesize, int firstRow, int lastRow,
+                                    AsciiGrid &outGrid, bool enableColor, const uint8_t* dirty) {
+    // Grid dimensions are floor(src / block), so every block lies fully inside the frame
+    const int blockPixels = m_blockWidth * m_blockHeight;
 
     // Loop through each ASCII block (row by row, column by column)
-    for (int blockY = 0; blockY < outGrid.rows; ++blockY) {
+    for (int blockY = firstRow; blockY < lastRow; ++blockY) {
+        const uint8_t* blockRow = rgb + (blockY - firstRow) * m_blockHeight * linesize;
+        char* chars = outGrid.rowChars(blockY);
+        RGB* colours = outGrid.rowColours(blockY);
+        const uint8_t* rowDirty = dirty ? dirty + blockY * m_gridCols : nullptr;
         for (int blockX = 0; blockX < outGrid.cols; ++blockX) {
-            long rSum = 0, gSum = 0, bSum = 0, brightnessSum = 0;
-            int count = 0;
-
-            // Loop through each pixel in the current ASCII block
-            for (int dy = 0; dy < m_blockHeight; ++dy) {
-                for (int dx = 0; dx < m_blockWidth; ++dx) {
-                    int px = blockX * m_blockWidth + dx;
-                    int py = blockY * m_blockHeight + dy;
-
-                    // Boundary check (needed for edge cases on non-divisible resolutions)
-                    if (px >= m_srcWidth || py >= m_srcHeight)
-                        continue;
-
-                    // Compute pointer to pixel in RGB frame
-                    uint8_t* pixel = m_rgbFrame->data[0] + py * m_rgbFrame->linesize[0] + px * 3;
-                    uint8_t r = pixel[0];
-                    uint8_t g = pixel[1];
-                    uint8_t b = pixel[2];
-
-                    // Approximate luminance = 0.299R + 0.587G + 0.114B
-                    int brightness = (r * 299 + g * 587 + b * 114) / 1000;
-
-                    // Accumulate for averaging
-                    rSum += r;
-                    gSum += g;
-                    bSum += b;
-                    brightnessSum += brightness;
-                    count++;
-                }
+            if (rowDirty && !rowDirty[blockX]) {
+                chars[blockX] = m_previousGrid.charAt(blockY, blockX);
+                colours[blockX] = m_previousGrid.colourAt(blockY, blockX);
+                continue;
             }
 
+            BlockSums sums;
+            m_sumBlock(blockRow + blockX * m_blockWidth * 3, linesize, m_blockWidth, m_blockHeight, sums);
+
             // Compute average brightness and colour, and assign to grid
-            if (count > 0) {
-                int avgBrightness = static_cast<int>(std::round(static_cast<double>(brightnessSum) / count));
-                int index = (avgBrightness * (m_asciiChars.size() - 1)) / 255;
-
-                outGrid.chars[blockY][blockX] = m_asciiChars[index];
-                if(enableColor) {
-                    outGrid.colours[blockY][blockX] = RGB{
-                        static_cast<uint8_t>(rSum / count),
-                        static_cast<uint8_t>(gSum / count),
-                        static_cast<uint8_t>(bSum / count)
-                    }; // set average red, green and blue colours for the block
-                } else {
-                    outGrid.colours[blockY][blockX] = RGB{255, 255, 255};
-                }
+            int avgBrightness = static_cast<int>(std::round(static_cast<double>(sums.brightness) / blockPixels));
+
+            chars[blockX] = charForBrightness(avgBrightness);
+            if(enableColor) {
+                colours[blockX] = RGB{
+                    static_cast<uint8_t>(sums.r / blockPixels),
+                    static_cast<uint8_t>(sums.g / blockPixels),
+                    static_cast<uint8_t>(sums.b / blockPixels)
+                }; // set average red, green and blue colours for the block
+            } else {
+                colours[blockX] = RGB{255, 255, 255};
+            }
+        }
+    }
+}
+
+void AsciiConverter::convertYuv(AVFrame* decodedFrame, AsciiGrid &outGrid, bool enableColor, const uint8_t* dirty) {
+    // No intermediate buffer here; bands only spread the block loop over the threads
+    const bool timed = Stats::enabled();
+    std::atomic<int64_t> averageNanoseconds{0};
+    auto convertBand = [&](int bandIndex, int) {
+        const Band& band = m_bands[bandIndex];
+        if (dirty && !anyDirty(dirty, band.firstRow, band.lastRow, m_gridCols)) {
+            copyPreviousRows(band.firstRow, band.lastRow, outGrid);
+            return;
+        }
+        const auto averageStart = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        convertYuvRows(decodedFrame, band.firstRow, band.lastRow, outGrid, enableColor, dirty);
+        if (timed) {
+            averageNanoseconds += nanosecondsSince(averageStart);
+        }
+    };
+    forEachBand(convertBand);
+
+    if (timed) {
+        Stats::record(Stage::ConvertAverage, averageNanoseconds);
+    }
+}
+
+void AsciiConverter::convertYuvRows(const AVFrame* decodedFrame, int firstRow, int lastRow,
+                                    AsciiGrid &outGrid, bool enableColor, const uint8_t* dirty) {
+    // Means are affine-invariant, so converting the block's mean Y/U/V gives the same colour as
+    // averaging per-pixel RGB (up to clamping), at a fraction of the memory traffic.
+    const bool fullRange = m_fullRange || decodedFrame->color_range == AVCOL_RANGE_JPEG;
+    const int blockPixels = m_blockWidth * m_blockHeight;
+    const uint8_t* yPlane = decodedFrame->data[0];
+    const uint8_t* uPlane = decodedFrame->data[1];
+    const uint8_t* vPlane = decodedFrame->data[2];
+    const int yStride = decodedFrame->linesize[0];
+    const int uStride = decodedFrame->linesize[1];
+    const int vStride = decodedFrame->linesize[2];
+
+    for (int blockY = firstRow; blockY < lastRow; ++blockY) {
+        const int py = blockY * m_blockHeight;
+        // Chroma rows covering this block row (at least one, even for blocks smaller than a chroma sample)
+        const int cy0 = py >> m_chromaShiftY;
+        const int cy1 = std::max(cy0 + 1, (py + m_blockHeight) >> m_chromaShiftY);
+        char* chars = outGrid.rowChars(blockY);
+        RGB* colours = outGrid.rowColours(blockY);
+        const uint8_t* rowDirty = dirty ? dirty + blockY * m_gridCols : nullptr;
+
+        for (int blockX = 0; blockX < outGrid.cols; ++blockX) {
+            if (rowDirty && !rowDirty[blockX]) {
+                chars[blockX] = m_previousGrid.charAt(blockY, blockX);
+                colours[blockX] = m_previousGrid.colourAt(blockY, blockX);
+                continue;
+            }
+
+            const int px = blockX * m_blockWidth;
+            const float yMean = static_cast<float>(sumPlane(yPlane + py * yStride + px, yStride, m_blockWidth, m_blockHeight)) / blockPixels;
+
+            // BT.601, which is also what sws_scale assumes in RGB mode
+            const float luma = fullRange ? yMean : (yMean - 16.0f) * (255.0f / 219.0f);
+            const int avgBrightness = static_cast<int>(std::round(std::min(255.0f, std::max(0.0f, luma))));
+            chars[blockX] = charForBrightness(avgBrightness);
+
+            if (!enableColor) {
+                colours[blockX] = RGB{255, 255, 255};
+                continue;
+            }
+
+            const int cx0 = px >> m_chromaShiftX;
+            const int cx1 = std::max(cx0 + 1, (px + m_blockWidth) >> m_chromaShiftX);
+            const int chromaPixels = (cx1 - cx0) * (cy1 - cy0);
+            const float u = static_cast<float>(sumPlane(uPlane + cy0 * uStride + cx0, uStride, cx1 - cx0, cy1 - cy0)) / chromaPixels - 128.0f;
+            const float v = static_cast<float>(sumPlane(vPlane + cy0 * vStride + cx0, vStride, cx1 - cx0, cy1 - cy0)) / chromaPixels - 128.0f;
+
+            if (fullRange) {
+                colours[blockX] = RGB{
+                    clampToByte(luma + 1.402f * v),
+                    clampToByte(luma - 0.344136f * u - 0.714136f * v),
+                    clampToByte(luma + 1.772f * u)
+                };
             } else {
-                // safety fallback: empty cell
-                outGrid.chars[blockY][blockX] = ' ';
-                outGrid.colours[blockY][blockX] = RGB{0, 0, 0};
+                colours[blockX] = RGB{
+                    clampToByte(luma + 1.596f * v),
+                    clampToByte(luma - 0.392f * u - 0.813f * v),
+                    clampToByte(luma + 2.017f * u)
+                };
             }
         }
     }
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "AsciiTypes.hpp"  // Defines RGB and AsciiGrid structures
+#include "BlockKernels.hpp" // BlockSumFn, SIMD block averaging
+#include "ThreadPool.hpp"
 
 extern "C" {
     #include <libavutil/frame.h>     ///< AVFrame for decoded frames
@@ -15,12 +20,22 @@ extern "C" {
 
 namespace AsciiVideoFilter {
 
+/**
+ * @brief How AsciiConverter gets from a decoded frame to per-block averages.
+ */
+enum class ConversionMode {
+    RGB, ///< sws_scale each band of block rows to RGB24, then average its blocks (works for any input format)
+    YUV, ///< Average the Y and U/V planes in place and convert only the block means to RGB (8-bit planar YUV)
+    SCALE, ///< Let sws_scale downscale straight to gridCols x gridRows RGB24 (SWS_AREA by default), one pixel per cell
+};
+
 /**
  * @class AsciiConverter
  * @brief Converts decoded video frames into a structured ASCII grid representation.
  *
  * Converts AVFrames to RGB24, then samples pixel blocks (group of pixels that makes up a character) and
  * maps their brightness and average color to ASCII characters and RGB triplets.
+ * In ConversionMode::YUV the RGB24 frame is skipped and blocks are averaged straight from the decoder's planes.
  */
 class AsciiConverter {
 public:
@@ -70,18 +85,92 @@ public:
      */
     void setAsciiCharset(const std::string& charset) { m_asciiChars = charset; }
 
+    /**
+     * @brief Selects the conversion path. Takes effect on the next init().
+     *
+     * ConversionMode::YUV falls back to RGB if the source is not 8-bit planar YUV.
+     */
+    void setConversionMode(ConversionMode mode) { m_requestedMode = mode; }
+
+    /**
+     * @brief Sets the swscale filter used by ConversionMode::SCALE (SWS_AREA, SWS_BICUBIC, ...).
+     * Takes effect on the next init().
+     */
+    void setScaleFilter(int swsFlags) { m_scaleFilter = swsFlags; }
+
+    /**
+     * @brief Reuses the previous frame's cells where the decoder's motion vectors show no motion.
+     *
+     * Needs VideoDecoder::setExportMotionVectors(). For P frames that carry
+     * AV_FRAME_DATA_MOTION_VECTORS, only cells touched by a moving block, or not fully covered by
+     * motion-compensated blocks (intra blocks export no vector), are recomputed; the rest are copied
+     * from the previous frame. A zero vector points at a reference picture, which is only the
+     * previous grid when frames aren't reordered and P frames have a single reference, so streams
+     * with B-frames (setReorderDelay()) or more than one reference frame (setReferenceFrames()) are
+     * converted in full, as are keyframes and frames without vectors.
+     * Residual changes inside a zero-motion block are not seen, so slow fades can lag until the
+     * next keyframe. Applies to ConversionMode::RGB and ConversionMode::YUV; SCALE always converts
+     * in full.
+     */
+    void setMotionSkip(bool enable) { m_motionSkip = enable; }
+
+    /**
+     * @brief Frames the decoder reorders by (VideoDecoder::getReorderDelay()). Motion skip only
+     * reuses cells when this is 0; a B frame showing up later disables it as well.
+     */
+    void setReorderDelay(int frames) { m_reorderDelay = frames; }
+
+    /**
+     * @brief Reference frames a P frame may predict from (VideoDecoder::getReferenceFrames()), 0 if
+     * unknown. Motion vectors don't say which reference they use, so motion skip needs exactly 1.
+     */
+    void setReferenceFrames(int frames) { m_referenceFrames = frames; }
+
+    /**
+     * @brief Sets how many threads convert bands of block rows. Takes effect on the next init().
+     *
+     * RGB and YUV modes split the grid into bands of block rows; in RGB mode each thread converts the
+     * bands it picks up through its own SwsContext into a buffer small enough to still be in cache
+     * when their blocks are averaged. 0 means one thread per core; 1 (the default) converts on the caller's
+     * thread only. SCALE mode always converts on the caller's thread.
+     *
+     * YUV bands give the same grid as a single thread. RGB bands do for yuv420p, but each band is
+     * scaled on its own, so formats whose conversion interpolates chroma vertically can differ in
+     * the cells next to a band edge.
+     */
+    void setThreadCount(int threadCount) { m_requestedThreads = threadCount; }
+
+    /**
+     * @brief Threads converting bands, including the caller (1 until init() sets up a pool).
+     */
+    int getThreadCount() const { return m_threadPool ? m_threadPool->getThreadCount() : 1; }
+
+    /**
+     * @brief Number of row bands convert() splits the grid into (RGB and YUV modes).
+     */
+    int getBandCount() const { return static_cast<int>(m_bands.size()); }
+
+    /**
+     * @brief Fraction of grid cells actually recomputed over every convert() so far (1 without motion skip).
+     */
+    double getAverageRecomputedFraction() const {
+        return m_cellsConverted > 0 ? static_cast<double>(m_cellsRecomputed) / m_cellsConverted : 0.0;
+    }
+
     // Getters
     int getBlockHeight() { return m_blockHeight; }
     int getBlockWidth() { return m_blockWidth; }
     int getGridRows() const { return m_gridRows; }
     int getGridCols() const { return m_gridCols; }
+    const char* getKernelName() const { return m_kernelName; }
+    ConversionMode getConversionMode() const { return m_mode; }
 
 
 private:
     char m_errbuf[AV_ERROR_MAX_STRING_SIZE];
-    SwsContext *m_swsContext;   ///< Used to convert from input format to RGB24
-    AVFrame *m_rgbFrame;        ///< Internal RGB24 frame buffer
-    uint8_t *m_rgbBuffer;       ///< Buffer for RGB image data
+    SwsContext *m_swsContext;   ///< Downscales to the grid-sized RGB24 image (SCALE mode)
+    AVFrame *m_rgbFrame;        ///< Internal RGB24 frame buffer (SCALE mode)
+    uint8_t *m_rgbBuffer;       ///< Buffer for RGB image data (SCALE mode)
 
     int m_srcWidth;             ///< Width of source frame
     int m_srcHeight;            ///< Height of source frame
@@ -91,13 +180,108 @@ private:
     int m_gridCols;
     int m_gridRows;
 
+    BlockSumFn m_sumBlock;      ///< Block averaging kernel picked for this CPU in init()
+    const char* m_kernelName;
+
+    ConversionMode m_requestedMode; ///< Mode asked for through setConversionMode()
+    ConversionMode m_mode;          ///< Mode actually in use after init()
+    int m_chromaShiftX;             ///< log2 horizontal chroma subsampling (YUV mode)
+    int m_chromaShiftY;             ///< log2 vertical chroma subsampling (YUV mode)
+    bool m_fullRange;               ///< Source pixel format is full range (yuvj*)
+    int m_scaleFilter;              ///< swscale filter flags for SCALE mode
+
     std::string m_asciiChars;   ///< Characters used for brightness-to-ASCII mapping
 
+    // Motion skip: cells are copied from m_previousGrid where m_cellDirty is 0
+    bool m_motionSkip = false;
+    int m_reorderDelay = 0;             ///< Decoder's has_b_frames; motion skip needs 0
+    int m_referenceFrames = 0;          ///< Stream's reference frame count; motion skip needs 1
+    bool m_reorderSeen = false;         ///< A B frame was converted, so frames are reordered
+    AsciiGrid m_previousGrid;           ///< Last grid convert() produced
+    bool m_previousValid = false;
+    bool m_previousColour = true;       ///< enableColour m_previousGrid was converted with
+    std::vector<uint8_t> m_cellDirty;   ///< Per cell (grid stride): 1 = recompute
+    std::vector<int> m_cellCoverage;    ///< Per cell: pixels covered by zero-motion blocks
+    int64_t m_cellsRecomputed = 0;
+    int64_t m_cellsConverted = 0;
+
+    // Row bands (RGB and YUV modes). All bands have m_rowsPerBand block rows except perhaps the last.
+    struct Band {
+        int firstRow;             ///< First block row of the band
+        int lastRow;              ///< One past the last block row
+    };
+    // Per convert thread (RGB mode). A thread converts one band at a time, so nothing here is shared.
+    // The contexts only depend on the band height, so there is one per distinct height, not per band.
+    struct Scratch {
+        uint8_t* rgb = nullptr;            ///< One band of RGB24 rows
+        SwsContext* fullBand = nullptr;    ///< Converts a band of m_rowsPerBand block rows
+        SwsContext* lastBand = nullptr;    ///< Converts the last band when it is shorter
+    };
+    static constexpr size_t kBandBytes = 256 * 1024; ///< RGB24 band size aimed for, to stay within L2
+    static constexpr int kBandsPerThread = 4;        ///< More bands than threads, so uneven bands balance out
+    std::vector<Band> m_bands;
+    int m_rowsPerBand = 0;
+    std::vector<Scratch> m_scratch;   ///< Indexed by the thread running a band (RGB mode)
+    int m_bandLinesize = 0;           ///< Row stride of the Scratch::rgb buffers
+    int m_requestedThreads = 1;
+    std::unique_ptr<ThreadPool> m_threadPool; ///< Only when converting with more than one thread
+
     /**
      * @brief Frees all allocations and resets members.
      */
     void cleanup();
 
+    /**
+     * @brief Fills m_cellDirty from the frame's motion vectors.
+     * @return Number of dirty cells, or -1 if the frame can't be skipped (not a P frame, reordered
+     *         or multi-reference stream, no vectors, no usable previous grid) and must be converted
+     *         in full.
+     */
+    int buildDirtyMask(const AVFrame* decodedFrame, bool enableColour);
+
+    /**
+     * @brief Splits the grid rows into m_bands and, in RGB mode, sets up each thread's Scratch.
+     *
+     * Band starts are kept on chroma row boundaries so every band's planes can be addressed on
+     * their own.
+     * @return 0 on success, or negative AppErrorCode/FFmpeg error on failure.
+     */
+    int initBands(AVPixelFormat srcPixFmt);
+
+    /**
+     * @brief Runs fn(band, thread) for every band, on the pool when there is one.
+     */
+    template <typename Fn>
+    void forEachBand(Fn&& fn) {
+        if (m_threadPool) {
+            m_threadPool->parallelFor(static_cast<int>(m_bands.size()), fn);
+        } else {
+            for (int band = 0; band < static_cast<int>(m_bands.size()); ++band) {
+                fn(band, 0);
+            }
+        }
+    }
+
+    // Per-mode halves of convert(). dirty (per cell, grid stride) limits the work to cells set to 1,
+    // copying the rest from m_previousGrid; nullptr converts every cell.
+    void convertRgb(AVFrame* decodedFrame, AsciiGrid& outGrid, bool enableColour, const uint8_t* dirty);
+    void convertYuv(AVFrame* decodedFrame, AsciiGrid& outGrid, bool enableColour, const uint8_t* dirty);
+    void convertScaled(AVFrame* decodedFrame, AsciiGrid& outGrid, bool enableColour);
+
+    // Block loops over block rows [firstRow, lastRow). rgb points at the first pixel row of firstRow.
+    void convertRgbRows(const uint8_t* rgb, int linesize, int firstRow, int lastRow,
+                        AsciiGrid& outGrid, bool enableColour, const uint8_t* dirty);
+    void convertYuvRows(const AVFrame* decodedFrame, int firstRow, int lastRow,
+                        AsciiGrid& outGrid, bool enableColour, const uint8_t* dirty);
+
+    // Copies cells of block rows [firstRow, lastRow) from m_previousGrid
+    void copyPreviousRows(int firstRow, int lastRow, AsciiGrid& outGrid);
+
+    // Maps an average 0-255 brightness onto the charset
+    char charForBrightness(int brightness) const {
+        return m_asciiChars[(brightness * (m_asciiChars.size() - 1)) / 255];
+    }
+
     // no copy constructor and assignment operator
     AsciiConverter(const AsciiConverter&) = delete;
     AsciiConverter& operator=(const AsciiConverter&) = delete;
@@ -1,11 +1,17 @@
 #include "AsciiRenderer.hpp"
+#include "Stats.hpp"
 #include "Utils.hpp"
 
 
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 #include <cstring> // for memset
-#include <cassert>
+#include <new>
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
 #define STB_TRUETYPE_IMPLEMENTATION
 
 extern "C" {
@@ -59,11 +65,12 @@ void AsciiRenderer::cleanup() {
         m_frame = nullptr;
     }
 
-    // Free cached glyph bitmaps
-    for (auto const& [key, val] : m_glyphCache) {
-        stbtt_FreeBitmap(val.bitmap, nullptr);
-    }
-    m_glyphCache.clear();
+    m_glyphAtlas.clear();
+    m_chromaAtlas.clear();
+    m_previousValid = false;
+    m_scratch.clear();
+    m_threadPool.reset();
+    m_bandRedrawn.clear();
 }
 
 bool AsciiRenderer::loadFont(const std::string& path) {
@@ -136,7 +143,9 @@ int AsciiRenderer::initFont(const std::string& fontPath, int fontHeight) {
         m_fontBuffer = nullptr;
         return AVERROR(ENOMEM);
     }
-    return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
+
+    // A new font invalidates any atlas built for the previous one
+    return buildGlyphAtlas();
 }
 
 int AsciiRenderer::initFrame(int targetFrameWidth, int targetFrameHeight, int blockWidth, int blockHeight) {
@@ -147,6 +156,18 @@ int AsciiRenderer::initFrame(int targetFrameWidth, int targetFrameHeight, int bl
     m_frameWidth = targetFrameWidth;
     m_frameHeight = targetFrameHeight;
 
+    m_format = m_requestedFormat;
+    if (m_format != AV_PIX_FMT_RGB24 && m_format != AV_PIX_FMT_YUV420P) {
+        std::cerr << "Warning (AsciiRenderer::initFrame): Unsupported output format "
+                  << av_get_pix_fmt_name(m_format) << ", rendering rgb24 instead.\n";
+        m_format = AV_PIX_FMT_RGB24;
+    }
+    if (m_format == AV_PIX_FMT_YUV420P && (blockWidth % 2 != 0 || blockHeight % 2 != 0)) {
+        std::cerr << "Warning (AsciiRenderer::initFrame): yuv420p output needs even block dimensions, got "
+                  << blockWidth << "x" << blockHeight << ". Rendering rgb24 instead.\n";
+        m_format = AV_PIX_FMT_RGB24;
+    }
+
     // Allocate AVFrame structure
     m_frame = av_frame_alloc();
     if (!m_frame) {
@@ -154,12 +175,12 @@ int AsciiRenderer::initFrame(int targetFrameWidth, int targetFrameHeight, int bl
         return AVERROR(ENOMEM); // Out of memory
     }
 
-    m_frame->format = AV_PIX_FMT_RGB24;
+    m_frame->format = m_format;
     m_frame->width = m_frameWidth;
     m_frame->height = m_frameHeight;
 
     // Get buffer size and allocate it
-    int bufferSize = av_image_get_buffer_size(AV_PIX_FMT_RGB24, m_frameWidth, m_frameHeight, 32);
+    int bufferSize = av_image_get_buffer_size(m_format, m_frameWidth, m_frameHeight, 32);
     if (bufferSize < 0) {
         std::cerr << "Invalid image buffer size.\n";
         av_frame_free(&m_frame); // Free m_frame struct on buffer size error
@@ -175,7 +196,7 @@ int AsciiRenderer::initFrame(int targetFrameWidth, int targetFrameHeight, int bl
         return AVERROR(ENOMEM);
     }
 
-    int ret = av_image_fill_arrays(m_frame->data, m_frame->linesize, m_frameBuffer, AV_PIX_FMT_RGB24,
+    int ret = av_image_fill_arrays(m_frame->data, m_frame->linesize, m_frameBuffer, m_format,
                                    m_frameWidth, m_frameHeight, 32);
     if (ret < 0) {
         // If av_image_fill_arrays fails, free both m_frameBuffer and m_frame
@@ -187,91 +208,371 @@ int AsciiRenderer::initFrame(int targetFrameWidth, int targetFrameHeight, int bl
         return ret;
     }
 
-    std::memset(m_frameBuffer, 0, bufferSize);  // Clear to black
+    // Clear to black once. render() rewrites every pixel of every cell, so only the strip right of
+    // and below the last full cell keeps this.
+    if (m_format == AV_PIX_FMT_YUV420P) {
+        const int chromaHeight = (m_frameHeight + 1) / 2;
+        std::memset(m_frame->data[0], 16, static_cast<size_t>(m_frame->linesize[0]) * m_frameHeight);
+        std::memset(m_frame->data[1], 128, static_cast<size_t>(m_frame->linesize[1]) * chromaHeight);
+        std::memset(m_frame->data[2], 128, static_cast<size_t>(m_frame->linesize[2]) * chromaHeight);
+    } else {
+        std::memset(m_frameBuffer, 0, bufferSize);
+    }
+
+    m_threadPool.reset();
+    if (m_requestedThreads != 1) {
+        m_threadPool.reset(new ThreadPool(m_requestedThreads));
+        if (m_threadPool->getThreadCount() == 1) {
+            m_threadPool.reset();
+        }
+    }
+    return buildGlyphAtlas();
+}
+
+int AsciiRenderer::buildGlyphAtlas() {
+    // New glyphs or a new frame: nothing on screen can be reused
+    m_previousValid = false;
+
+    // Needs both the font and the cell size; whichever of initFont/initFrame runs last builds it
+    if (!m_fontInfo || m_blockWidth <= 0 || m_blockHeight <= 0) {
+        return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
+    }
+
+    auto* font = static_cast<stbtt_fontinfo*>(m_fontInfo);
+    const bool yuv = m_format == AV_PIX_FMT_YUV420P;
+    const int channels = yuv ? 1 : 3;
+    const size_t tileSize = static_cast<size_t>(m_blockWidth) * channels * m_blockHeight;
+    const int chromaWidth = m_blockWidth / 2;
+    const int chromaHeight = m_blockHeight / 2;
+    const size_t chromaTileSize = static_cast<size_t>(chromaWidth) * chromaHeight;
+    try {
+        // Slack at the end of each buffer for the chunked tile-row copies in gatherTileRow
+        m_glyphAtlas.assign(256 * tileSize + kCopyChunk, 0);
+        m_chromaAtlas.assign(yuv ? 256 * chromaTileSize + kCopyChunk : 0, 0);
+        m_scratch.resize(getThreadCount());
+        for (Scratch& scratch : m_scratch) {
+            scratch.colourLine.assign(static_cast<size_t>(m_frameWidth) * 3, 0);
+            scratch.chromaLines.assign(yuv ? static_cast<size_t>(m_frameWidth + 1) / 2 * 4 : 0, 0);
+            scratch.coverageLine.assign(static_cast<size_t>(m_frameWidth) * 3 + kCopyChunk, 0);
+        }
+        m_bandRedrawn.assign(static_cast<size_t>(getThreadCount()) * kBandsPerThread, 0);
+    } catch (const std::bad_alloc&) {
+        std::cerr << "Error (AsciiRenderer::buildGlyphAtlas): Failed to allocate glyph atlas.\n";
+        return AVERROR(ENOMEM);
+    }
+
+    // Only printable ASCII gets rasterized; every other byte value keeps a blank tile
+    for (int c = 32; c < 127; ++c) {
+        int width, height, xoff, yoff;
+        unsigned char* bitmap = stbtt_GetCodepointBitmap(font, 0, m_scale, c, &width, &height, &xoff, &yoff);
+        if (!bitmap) {
+            continue; // no outline, e.g. space
+        }
+
+        // The glyph's origin sits at (0, ascent) inside the cell; keep only what lands within the cell
+        const int top = m_ascent + yoff;
+        const int firstRow = std::max(0, -top);
+        const int lastRow = std::min(height, m_blockHeight - top);
+        const int firstCol = std::max(0, -xoff);
+        const int lastCol = std::min(width, m_blockWidth - xoff);
+
+        uint8_t* tile = m_glyphAtlas.data() + c * tileSize;
+        for (int gy = firstRow; gy < lastRow; ++gy) {
+            const unsigned char* src = bitmap + gy * width;
+            uint8_t* dst = tile + ((top + gy) * m_blockWidth + xoff) * channels;
+            for (int gx = firstCol; gx < lastCol; ++gx) {
+                for (int ch = 0; ch < channels; ++ch) {
+                    dst[gx * channels + ch] = src[gx];
+                }
+            }
+        }
+        stbtt_FreeBitmap(bitmap, nullptr);
+
+        if (yuv) {
+            // Chroma is subsampled 2x2, so each chroma sample sees the mean coverage of its four pixels
+            uint8_t* chromaTile = m_chromaAtlas.data() + c * chromaTileSize;
+            for (int cy = 0; cy < chromaHeight; ++cy) {
+                const uint8_t* upper = tile + (cy * 2) * m_blockWidth;
+                const uint8_t* lower = upper + m_blockWidth;
+                for (int cx = 0; cx < chromaWidth; ++cx) {
+                    const int sum = upper[cx * 2] + upper[cx * 2 + 1] + lower[cx * 2] + lower[cx * 2 + 1];
+                    chromaTile[cy * chromaWidth + cx] = static_cast<uint8_t>((sum + 2) >> 2);
+                }
+            }
+        }
+    }
+
     return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
 }
 
 AVFrame* AsciiRenderer::render(const AsciiGrid& grid, bool enableColour) {
-    if (!m_frame || !m_fontInfo) {
+    if (!m_frame || !m_fontInfo || m_glyphAtlas.empty()) {
         std::cerr << "Renderer not initialized.\n";
         return nullptr;
     }
+    Stats::ScopedTimer timer(Stage::Render);
+
+    // Cells that would not fit entirely inside the frame are skipped
+    const int rows = std::min(grid.rows, m_frameHeight / m_blockHeight);
+    const int cols = std::min(grid.cols, m_frameWidth / m_blockWidth);
+
+    // m_frame still holds the previous render; only cells that differ from m_previousGrid are redrawn.
+    // Each tile overwrites its whole cell, so redrawing doubles as clearing.
+    const bool redrawAll = !m_previousValid || enableColour != m_previousColour ||
+                           grid.rows != m_previousGrid.rows || grid.cols != m_previousGrid.cols;
+
+    // Every band writes only its own rows of each plane, so the result doesn't depend on the split
+    const int bands = std::max(1, std::min(rows, static_cast<int>(m_bandRedrawn.size())));
+    auto renderBand = [&](int band, int thread) {
+        const int firstRow = static_cast<int>(static_cast<int64_t>(rows) * band / bands);
+        const int lastRow = static_cast<int>(static_cast<int64_t>(rows) * (band + 1) / bands);
+        m_bandRedrawn[band] = renderRows(grid, firstRow, lastRow, cols, redrawAll, enableColour, m_scratch[thread]);
+    };
+    if (m_threadPool) {
+        m_threadPool->parallelFor(bands, renderBand);
+    } else {
+        for (int band = 0; band < bands; ++band) {
+            renderBand(band, 0);
+        }
+    }
+
+    int64_t redrawn = 0;
+    for (int band = 0; band < bands; ++band) {
+        redrawn += m_bandRedrawn[band];
+    }
+
+    m_previousGrid = grid;
+    m_previousColour = enableColour;
+    m_previousValid = true;
 
-    // Clear the frame each time before rendering
-    int bufferSize = av_image_get_buffer_size(AV_PIX_FMT_RGB24, m_frameWidth, m_frameHeight, 32);
-    std::memset(m_frameBuffer, 0, bufferSize);
+    const int64_t cells = static_cast<int64_t>(rows) * cols;
+    m_lastRedrawFraction = cells > 0 ? static_cast<double>(redrawn) / cells : 0.0;
+    m_cellsRedrawn += redrawn;
+    m_cellsRendered += cells;
 
-    for (int row = 0; row < grid.rows; ++row) {
-        for (int col = 0; col < grid.cols; ++col) {
-            char c = grid.chars[row][col];
-            RGB color = grid.colours[row][col];
+    return m_frame;
+}
 
-            int x = col * m_blockWidth;
-            int y = row * m_blockHeight + m_ascent;
+int64_t AsciiRenderer::renderRows(const AsciiGrid& grid, int firstRow, int lastRow, int cols, bool redrawAll,
+                                  bool enableColour, Scratch& scratch) {
+    int64_t redrawn = 0;
+    for (int row = firstRow; row < lastRow; ++row) {
+        const char* chars = grid.rowChars(row);
+        const RGB* colours = grid.rowColours(row);
+        if (redrawAll) {
+            drawCells(scratch, chars, colours, row, 0, cols, enableColour);
+            redrawn += cols;
+            continue;
+        }
 
-            drawGlyph(c, x, y, color, enableColour);
+        const char* previousChars = m_previousGrid.rowChars(row);
+        const RGB* previousColours = m_previousGrid.rowColours(row);
+        auto changed = [&](int col) {
+            if (chars[col] != previousChars[col]) {
+                return true;
+            }
+            // Colour is ignored in monochrome, so a colour-only change leaves the cell as it is
+            const RGB& a = colours[col];
+            const RGB& b = previousColours[col];
+            return enableColour && (a.r != b.r || a.g != b.g || a.b != b.b);
+        };
+
+        for (int col = 0; col < cols;) {
+            if (!changed(col)) {
+                ++col;
+                continue;
+            }
+            // Grow the run over short clean gaps: redrawing a few unchanged cells is cheaper than
+            // paying the per-run setup again
+            int lastDirty = col;
+            for (int next = col + 1; next < cols && next - lastDirty <= kMaxCleanGap; ++next) {
+                if (changed(next)) {
+                    lastDirty = next;
+                }
+            }
+            const int count = lastDirty - col + 1;
+            drawCells(scratch, chars + col, colours + col, row, col, count, enableColour);
+            redrawn += count;
+            col = lastDirty + 1;
         }
     }
+    return redrawn;
+}
 
-    return m_frame;
+// value * alpha / 255, truncated, without a divide (exact for any 8-bit value and alpha)
+static inline uint8_t scaleByCoverage(uint8_t value, uint8_t alpha) {
+    const uint32_t x = static_cast<uint32_t>(value) * alpha;
+    return static_cast<uint8_t>((x + 1 + (x >> 8)) >> 8);
 }
 
-void AsciiRenderer::drawGlyph(char c, int x, int y, RGB color, bool enableColour) {
+#ifdef __SSE2__
+// Same as scaleByCoverage on eight byte pairs at once (held in the low halves of 16-bit lanes)
+static inline __m128i scaleByCoverageSse2(__m128i values, __m128i alphas) {
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i x = _mm_mullo_epi16(values, alphas);
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8);
+}
+#endif
+
+// dst[i] = bias + colours[i] * coverage[i] / 255
+static inline void blendLine(uint8_t* dst, const uint8_t* colours, const uint8_t* coverage, int count, uint8_t bias = 0) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i offset = _mm_set1_epi16(bias);
+    for (; i + 16 <= count; i += 16) {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colours + i));
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coverage + i));
+        const __m128i lo = scaleByCoverageSse2(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(a, zero));
+        const __m128i hi = scaleByCoverageSse2(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(a, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         _mm_packus_epi16(_mm_add_epi16(lo, offset), _mm_add_epi16(hi, offset)));
+    }
+    for (; i + 8 <= count; i += 8) {
+        const __m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(colours + i));
+        const __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(coverage + i));
+        const __m128i lo = scaleByCoverageSse2(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(a, zero));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(_mm_add_epi16(lo, offset), zero));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = static_cast<uint8_t>(bias + scaleByCoverage(colours[i], coverage[i]));
+    }
+}
 
-    assert(c >= 32 && c != 127 && "drawGlyph: character must be printable ASCII (32–126)");
-    if (!m_frame || !m_fontInfo)
-        return;
-    assert(m_frame->format == AV_PIX_FMT_RGB24);
+// dst[i] = 128 + (positive[i] - negative[i]) * coverage[i] / 255, for chroma offsets split by sign
+// (at most one of the two is non-zero) so the unsigned blend above can truncate towards zero
+static inline void blendChromaLine(uint8_t* dst, const uint8_t* positive, const uint8_t* negative,
+                                   const uint8_t* coverage, int count) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i neutral = _mm_set1_epi16(128);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(coverage + i)), zero);
+        const __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(positive + i)), zero);
+        const __m128i n = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(negative + i)), zero);
+        const __m128i value = _mm_sub_epi16(_mm_add_epi16(neutral, scaleByCoverageSse2(p, a)), scaleByCoverageSse2(n, a));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(value, zero));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = static_cast<uint8_t>(128 + scaleByCoverage(positive[i], coverage[i]) - scaleByCoverage(negative[i], coverage[i]));
+    }
+}
 
-    auto* font = static_cast<stbtt_fontinfo*>(m_fontInfo);
+void AsciiRenderer::gatherTileRow(Scratch& scratch, const uint8_t* atlasRow, size_t tileSize, int rowBytes, const char* chars, int cols) {
+    // Tile rows move in whole kCopyChunk pieces so every copy is a fixed size; the overshoot lands in
+    // the next cell, which is written right after, or in the slack at the end of the line.
+    uint8_t* gather = scratch.coverageLine.data();
+    for (int col = 0; col < cols; ++col, gather += rowBytes) {
+        const uint8_t* src = atlasRow + static_cast<unsigned char>(chars[col]) * tileSize;
+        for (int i = 0; i < rowBytes; i += kCopyChunk) {
+            std::memcpy(gather + i, src + i, kCopyChunk);
+        }
+    }
+}
 
-    unsigned char* glyph_bitmap = nullptr;
-    int width, height, xoff, yoff;
-
-    auto it = m_glyphCache.find(c);
-    if(it != m_glyphCache.end()) {
-        // glyph found in cache
-        glyph_bitmap = it->second.bitmap;
-        width = it->second.width;
-        height = it->second.height;
-        xoff = it->second.xoff;
-        yoff = it->second.yoff;
+void AsciiRenderer::drawCells(Scratch& scratch, const char* chars, const RGB* colours, int row, int firstCol, int cols, bool enableColour) {
+    if (m_format == AV_PIX_FMT_YUV420P) {
+        drawCellsYuv(scratch, chars, colours, row, firstCol, cols, enableColour);
     } else {
-        // glyph not found in cache, generate and cache it 
-        // since the char set itself is small enough we can just store all of them without some kinda lru or fifo
-        auto *font = static_cast<stbtt_fontinfo*>(m_fontInfo);
-        glyph_bitmap = stbtt_GetCodepointBitmap(font, 0, m_scale, c, &width, &height, &xoff, &yoff);
-        // assert(glyph_bitmap != nullptr && "Fatal Error: Glyph bitmap could not be generated.");
-        if(!glyph_bitmap) return;
+        drawCellsRgb(scratch, chars, colours, row, firstCol, cols, enableColour);
+    }
+}
 
-        m_glyphCache[c] = {glyph_bitmap, width, height, xoff, yoff}; // cache the glyph 
+void AsciiRenderer::drawCellsRgb(Scratch& scratch, const char* chars, const RGB* colours, int row, int firstCol, int cols, bool enableColour) {
+    // Copied into locals first: stores through uint8_t* may alias the members
+    const int rowBytes = m_blockWidth * 3;
+    const int blockHeight = m_blockHeight;
+    const int linesize = m_frame->linesize[0];
+    const size_t tileSize = static_cast<size_t>(rowBytes) * blockHeight;
+    const uint8_t* atlas = m_glyphAtlas.data();
+    uint8_t* colourLine = scratch.colourLine.data();
+    uint8_t* coverageLine = scratch.coverageLine.data();
+    const int lineBytes = cols * rowBytes;
+
+    if (enableColour) {
+        // Each cell's colour repeated across its width, shared by every scanline of this grid row
+        uint8_t* out = colourLine;
+        for (int col = 0; col < cols; ++col) {
+            const RGB colour = colours[col];
+            for (int i = 0; i < rowBytes; i += 3, out += 3) {
+                out[0] = colour.r;
+                out[1] = colour.g;
+                out[2] = colour.b;
+            }
+        }
     }
 
-    for (int gy = 0; gy < height; ++gy) {
-        for (int gx = 0; gx < width; ++gx) {
-            int dstX = x + gx + xoff;
-            int dstY = y + gy + yoff;
-            if (dstX < 0 || dstX >= m_frameWidth || dstY < 0 || dstY >= m_frameHeight)
-                continue;
+    // Scanline by scanline: gather each cell's tile row into one line, then blend (or copy) it in one go
+    for (int gy = 0; gy < blockHeight; ++gy) {
+        gatherTileRow(scratch, atlas + gy * rowBytes, tileSize, rowBytes, chars, cols);
 
-            int dstIndex = dstY * m_frame->linesize[0] + dstX * 3;
-            float alpha = glyph_bitmap[gy * width + gx] / 255.0f;
-
-            if(enableColour) {
-                // set color
-                m_frame->data[0][dstIndex + 0] = static_cast<uint8_t>(color.r * alpha);
-                m_frame->data[0][dstIndex + 1] = static_cast<uint8_t>(color.g * alpha);
-                m_frame->data[0][dstIndex + 2] = static_cast<uint8_t>(color.b * alpha);
-            } else {
-                // For monochrome, use the character brightness to determine grayscale intensity
-                // Calculate brightness from the character's position in the ASCII set
-                float brightness = alpha * 255.0f; // Use glyph alpha as brightness
-                uint8_t gray = static_cast<uint8_t>(brightness);
-                m_frame->data[0][dstIndex + 0] = gray;
-                m_frame->data[0][dstIndex + 1] = gray;
-                m_frame->data[0][dstIndex + 2] = gray;
-            }
+        uint8_t* dst = m_frame->data[0] + (row * blockHeight + gy) * linesize + firstCol * rowBytes;
+        if (enableColour) {
+            blendLine(dst, colourLine, coverageLine, lineBytes);
+        } else {
+            // Monochrome: the glyph coverage itself is the grey level
+            std::memcpy(dst, coverageLine, lineBytes);
         }
     }
 }
+
+void AsciiRenderer::drawCellsYuv(Scratch& scratch, const char* chars, const RGB* colours, int row, int firstCol, int cols, bool enableColour) {
+    // Every pixel of a cell is colour * coverage / 255 and the RGB -> YUV matrix is linear, so each
+    // plane is the cell's colour converted once, scaled by the (luma or 2x2-averaged) coverage.
+    const int blockWidth = m_blockWidth;
+    const int blockHeight = m_blockHeight;
+    const int chromaWidth = blockWidth / 2;
+    const int chromaHeight = blockHeight / 2;
+    const size_t tileSize = static_cast<size_t>(blockWidth) * blockHeight;
+    const size_t chromaTileSize = static_cast<size_t>(chromaWidth) * chromaHeight;
+    const int lumaBytes = cols * blockWidth;
+    const int chromaBytes = cols * chromaWidth;
+    const int chromaStride = static_cast<int>(scratch.chromaLines.size() / 4);
+
+    uint8_t* lumaLine = scratch.colourLine.data();
+    uint8_t* uPositive = scratch.chromaLines.data();
+    uint8_t* uNegative = uPositive + chromaStride;
+    uint8_t* vPositive = uNegative + chromaStride;
+    uint8_t* vNegative = vPositive + chromaStride;
+    const uint8_t* coverageLine = scratch.coverageLine.data();
+
+    for (int col = 0; col < cols; ++col) {
+        // Monochrome is white text: full luma, neutral chroma
+        const RGB c = enableColour ? colours[col] : RGB{255, 255, 255};
+        // BT.601 limited range without the +16/+128 offsets, which the blends add back
+        const int y = (66 * c.r + 129 * c.g + 25 * c.b + 128) >> 8;
+        const int u = (-38 * c.r - 74 * c.g + 112 * c.b + 128) >> 8;
+        const int v = (112 * c.r - 94 * c.g - 18 * c.b + 128) >> 8;
+        for (int i = 0; i < blockWidth; ++i) {
+            lumaLine[col * blockWidth + i] = static_cast<uint8_t>(y);
+        }
+        for (int i = 0; i < chromaWidth; ++i) {
+            const int at = col * chromaWidth + i;
+            uPositive[at] = static_cast<uint8_t>(u > 0 ? u : 0);
+            uNegative[at] = static_cast<uint8_t>(u < 0 ? -u : 0);
+            vPositive[at] = static_cast<uint8_t>(v > 0 ? v : 0);
+            vNegative[at] = static_cast<uint8_t>(v < 0 ? -v : 0);
+        }
+    }
+
+    const int lumaLinesize = m_frame->linesize[0];
+    uint8_t* lumaDst = m_frame->data[0] + row * blockHeight * lumaLinesize + firstCol * blockWidth;
+    for (int gy = 0; gy < blockHeight; ++gy, lumaDst += lumaLinesize) {
+        gatherTileRow(scratch, m_glyphAtlas.data() + gy * blockWidth, tileSize, blockWidth, chars, cols);
+        blendLine(lumaDst, lumaLine, coverageLine, lumaBytes, 16);
+    }
+
+    const int uLinesize = m_frame->linesize[1];
+    const int vLinesize = m_frame->linesize[2];
+    uint8_t* uDst = m_frame->data[1] + row * chromaHeight * uLinesize + firstCol * chromaWidth;
+    uint8_t* vDst = m_frame->data[2] + row * chromaHeight * vLinesize + firstCol * chromaWidth;
+    for (int cy = 0; cy < chromaHeight; ++cy, uDst += uLinesize, vDst += vLinesize) {
+        gatherTileRow(scratch, m_chromaAtlas.data() + cy * chromaWidth, chromaTileSize, chromaWidth, chars, cols);
+        blendChromaLine(uDst, uPositive, uNegative, coverageLine, chromaBytes);
+        blendChromaLine(vDst, vPositive, vNegative, coverageLine, chromaBytes);
+    }
+}
 } // namespace AsciiVideoFilter
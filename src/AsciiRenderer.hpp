@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include "AsciiTypes.hpp"
+#include "ThreadPool.hpp"
 
 extern "C" {
     #include <libavutil/error.h>
@@ -12,15 +15,6 @@ extern "C" {
 
 namespace AsciiVideoFilter {
 
-// Struct to stores cache glyph bitmaps
-struct CachedGlyph {
-    unsigned char* bitmap;
-    int width;
-    int height;
-    int xoff;
-    int yoff;
-};
-
 class AsciiRenderer {
 public:
     /**
@@ -42,6 +36,37 @@ public:
      */
     int initFont(const std::string& fontPath, int fontHeight);
 
+    /**
+     * @brief Selects the pixel format render() produces. Must be called before initFrame().
+     *
+     * AV_PIX_FMT_RGB24 (default) or AV_PIX_FMT_YUV420P. YUV420P writes the Y, U and V planes
+     * directly (BT.601, limited range) so the encoder needs no colour conversion. It needs even
+     * block dimensions so every chroma sample belongs to a single cell; initFrame() falls back to
+     * RGB24 otherwise.
+     *
+     * @param format Requested output pixel format.
+     */
+    void setOutputFormat(AVPixelFormat format) { m_requestedFormat = format; }
+
+    /**
+     * @brief Pixel format of the frames render() returns, valid after initFrame().
+     */
+    AVPixelFormat getOutputFormat() const { return m_format; }
+
+    /**
+     * @brief Sets how many threads render() splits the grid across, in bands of rows. Must be called
+     * before initFrame().
+     *
+     * Output is identical for any count. 1 (default) renders on the calling thread only; 0 uses one
+     * thread per core.
+     */
+    void setThreadCount(int threadCount) { m_requestedThreads = threadCount; }
+
+    /**
+     * @brief Threads render() actually uses, valid after initFrame().
+     */
+    int getThreadCount() const { return m_threadPool ? m_threadPool->getThreadCount() : 1; }
+
     /**
      * @brief Initializes the output AVFrame dimensions and buffer.
      *
@@ -58,10 +83,25 @@ public:
      *
      * @param grid AsciiGrid containing characters and RGB values.
      * @param enableColor If false, renders in grayscale using character brightness only.
-     * @return AVFrame* pointing to the internal RGB frame.
+     * @return AVFrame* pointing to the internal frame, in getOutputFormat().
      */
     AVFrame* render(const AsciiGrid& grid, bool enableColor = true);
 
+    /**
+     * @brief Fraction (0-1) of grid cells the last render() actually redrew.
+     *
+     * render() keeps the previous grid and only redraws cells whose character (or, in colour,
+     * colour) changed, so this is 1 for the first frame and near 0 for static content.
+     */
+    double getLastRedrawFraction() const { return m_lastRedrawFraction; }
+
+    /**
+     * @brief Fraction of grid cells redrawn over every render() so far.
+     */
+    double getAverageRedrawFraction() const {
+        return m_cellsRendered > 0 ? static_cast<double>(m_cellsRedrawn) / m_cellsRendered : 0.0;
+    }
+
     /**
      * @brief Cleans up allocated frame, font, and buffers.
      */
@@ -72,7 +112,42 @@ private:
     uint8_t* m_fontBuffer;     ///< Raw font file buffer
     unsigned char* m_bitmap;   ///< Temporary buffer for glyph bitmaps
     void* m_fontInfo;          ///< Opaque pointer to font info (stbtt_fontinfo*)
-    std::unordered_map<char, CachedGlyph> m_glyphCache;
+
+    // Glyph atlas: one blockWidth x blockHeight coverage tile per byte value, with the glyph already
+    // offset by ascent/xoff/yoff and clipped to the cell. For RGB24 each coverage byte is stored three
+    // times so a tile row lines up byte for byte with a cell row; for YUV420P it is stored once, and
+    // m_chromaAtlas holds the matching (blockWidth/2) x (blockHeight/2) tiles of 2x2-averaged coverage.
+    // Built once both font and block size are known.
+    std::vector<uint8_t> m_glyphAtlas;
+    std::vector<uint8_t> m_chromaAtlas;
+    static constexpr int kCopyChunk = 16;  ///< Granularity of tile-row copies into Scratch::coverageLine
+
+    // Scratch lines for drawing one grid row; each render thread has its own set
+    struct Scratch {
+        std::vector<uint8_t> colourLine;   ///< Each cell colour (or Y) of a grid row, repeated across the cell
+        std::vector<uint8_t> chromaLines;  ///< Per-cell U and V magnitudes, split by sign (YUV420P only)
+        std::vector<uint8_t> coverageLine; ///< One scanline of glyph coverage for a grid row
+    };
+    std::vector<Scratch> m_scratch;        ///< Indexed by ThreadPool thread (0 when single-threaded)
+
+    // Band-parallel rendering: cells never overlap (the atlas clips glyphs to their cell), so bands
+    // of grid rows can be drawn concurrently with identical results
+    static constexpr int kBandsPerThread = 4; ///< More bands than threads, so dirty-heavy bands balance out
+    int m_requestedThreads = 1;
+    std::unique_ptr<ThreadPool> m_threadPool; ///< Only when rendering with more than one thread
+    std::vector<int64_t> m_bandRedrawn;       ///< Cells each band redrew in the current render()
+
+    // Dirty-cell tracking: what m_frame currently shows
+    static constexpr int kMaxCleanGap = 4; ///< Unchanged cells a redraw run may span to merge with the next
+    AsciiGrid m_previousGrid;
+    bool m_previousColour = true;
+    bool m_previousValid = false;          ///< False until m_frame holds a full render
+    double m_lastRedrawFraction = 0.0;
+    int64_t m_cellsRedrawn = 0;
+    int64_t m_cellsRendered = 0;
+
+    AVPixelFormat m_requestedFormat = AV_PIX_FMT_RGB24;
+    AVPixelFormat m_format = AV_PIX_FMT_RGB24; ///< Format actually rendered, after fallback
 
     float m_scale;             ///< Font scale computed from pixel height
     int m_ascent;              ///< Font ascent in pixels
@@ -87,7 +162,15 @@ private:
     int m_blockHeight;         ///< Height of a single glyph block
 private:
     bool loadFont(const std::string& path);
-    void drawGlyph(char c, int x, int y, RGB color, bool enableColor = true);
+    int buildGlyphAtlas();
+    void gatherTileRow(Scratch& scratch, const uint8_t* atlasRow, size_t tileSize, int rowBytes, const char* chars, int cols);
+    // Redraws the changed cells (or all, with redrawAll) of grid rows [firstRow, lastRow); returns the cells drawn
+    int64_t renderRows(const AsciiGrid& grid, int firstRow, int lastRow, int cols, bool redrawAll, bool enableColour,
+                       Scratch& scratch);
+    // Draws cols cells of grid row `row` starting at firstCol; chars/colours point at the first of them
+    void drawCells(Scratch& scratch, const char* chars, const RGB* colours, int row, int firstCol, int cols, bool enableColour);
+    void drawCellsRgb(Scratch& scratch, const char* chars, const RGB* colours, int row, int firstCol, int cols, bool enableColour);
+    void drawCellsYuv(Scratch& scratch, const char* chars, const RGB* colours, int row, int firstCol, int cols, bool enableColour);
 };
 
 } // namespace AsciiVideoFilter
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 namespace AsciiVideoFilter {
 
@@ -9,11 +11,65 @@ struct RGB {
     uint8_t r, g, b;
 };
 
+/**
+ * @brief Character and colour planes for one frame, each stored contiguously in row-major order.
+ *
+ * Cell (row, col) lives at index row * stride + col of both chars and colours, so converter and
+ * renderer can walk a row linearly instead of chasing one heap allocation per row.
+ */
 struct AsciiGrid {
-    std::vector<std::vector<char>> chars;
-    std::vector<std::vector<RGB>> colours; // for per-block RGB colouring
+    std::vector<char> chars;
+    std::vector<RGB> colours; // for per-block RGB colouring
     int rows = 0;
     int cols = 0;
+    int stride = 0; // elements between the starts of two consecutive rows
+
+    // Reallocates both planes for rows x cols cells, blank (space, black)
+    void resize(int newRows, int newCols) {
+        rows = newRows;
+        cols = newCols;
+        stride = newCols;
+        chars.assign(static_cast<size_t>(rows) * stride, ' ');
+        colours.assign(static_cast<size_t>(rows) * stride, RGB{0, 0, 0});
+    }
+
+    size_t index(int row, int col) const { return static_cast<size_t>(row) * stride + col; }
+
+    char& charAt(int row, int col) { return chars[index(row, col)]; }
+    char charAt(int row, int col) const { return chars[index(row, col)]; }
+    RGB& colourAt(int row, int col) { return colours[index(row, col)]; }
+    const RGB& colourAt(int row, int col) const { return colours[index(row, col)]; }
+
+    char* rowChars(int row) { return chars.data() + index(row, 0); }
+    const char* rowChars(int row) const { return chars.data() + index(row, 0); }
+    RGB* rowColours(int row) { return colours.data() + index(row, 0); }
+    const RGB* rowColours(int row) const { return colours.data() + index(row, 0); }
+
+    // 64-bit FNV-1a style hash of the cell contents, taken a word at a time. A quick reject only:
+    // different hashes mean different grids, but equal hashes don't prove equal grids (sameCells() does)
+    uint64_t hash() const {
+        uint64_t h = 0xcbf29ce484222325ull ^ (static_cast<uint64_t>(rows) << 32 | static_cast<uint32_t>(cols));
+        auto mix = [&h](const void* data, size_t bytes) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            for (; bytes >= 8; p += 8, bytes -= 8) {
+                uint64_t word;
+                std::memcpy(&word, p, 8);
+                h = (h ^ word) * 0x100000001b3ull;
+            }
+            for (; bytes > 0; ++p, --bytes) {
+                h = (h ^ *p) * 0x100000001b3ull;
+            }
+        };
+        mix(chars.data(), chars.size());
+        mix(colours.data(), colours.size() * sizeof(RGB));
+        return h;
+    }
+
+    // True if both grids have the same layout and every cell matches
+    bool sameCells(const AsciiGrid& other) const {
+        return rows == other.rows && cols == other.cols && stride == other.stride && chars == other.chars &&
+               std::memcmp(colours.data(), other.colours.data(), colours.size() * sizeof(RGB)) == 0;
+    }
 };
 
 } // namespace AsciiVideoFilter
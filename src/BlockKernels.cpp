@@ -0,0 +1,230 @@
+#include "BlockKernels.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define ASCII_KERNELS_X86 1
+    #include <immintrin.h>
+#endif
+
+namespace AsciiVideoFilter {
+namespace BlockKernels {
+
+// floor(x / 1000) == (x * kDiv1000Magic) >> 32 for every x < 6,100,000, and per-pixel
+// luminance sums never exceed 255 * 1000. Lets the SIMD kernels truncate each pixel like the scalar one.
+static constexpr uint32_t kDiv1000Magic = 4294968;
+
+void sumScalar(const uint8_t* src, int stride, int width, int height, BlockSums& out) {
+    uint32_t rSum = 0, gSum = 0, bSum = 0, brightnessSum = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* pixel = src + y * stride;
+        for (int x = 0; x < width; ++x, pixel += 3) {
+            uint32_t r = pixel[0];
+            uint32_t g = pixel[1];
+            uint32_t b = pixel[2];
+            rSum += r;
+            gSum += g;
+            bSum += b;
+            // Approximate luminance = 0.299R + 0.587G + 0.114B
+            brightnessSum += (r * 299 + g * 587 + b * 114) / 1000;
+        }
+    }
+    out.r = rSum;
+    out.g = gSum;
+    out.b = bSum;
+    out.brightness = brightnessSum;
+}
+
+#ifdef ASCII_KERNELS_X86
+
+// Both SIMD kernels work on 32-bit lanes holding one pixel each as r | g << 8 | b << 16.
+// Luminance comes from two pmaddwd: (r, g) . (299, 587) and (b, 0) . (114, 0).
+
+__attribute__((target("sse2")))
+static inline __m128i packPixelsSse2(const uint8_t* p) {
+    // 16 bytes hold pixels 0-3 at byte offsets 0, 3, 6, 9; shift each into its own lane
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i lane0 = _mm_set_epi32(0, 0, 0, 0x00FFFFFF);
+    const __m128i lane1 = _mm_set_epi32(0, 0, 0x00FFFFFF, 0);
+    const __m128i lane2 = _mm_set_epi32(0, 0x00FFFFFF, 0, 0);
+    const __m128i lane3 = _mm_set_epi32(0x00FFFFFF, 0, 0, 0);
+    __m128i t = _mm_and_si128(v, lane0);
+    t = _mm_or_si128(t, _mm_and_si128(_mm_slli_si128(v, 1), lane1));
+    t = _mm_or_si128(t, _mm_and_si128(_mm_slli_si128(v, 2), lane2));
+    t = _mm_or_si128(t, _mm_and_si128(_mm_slli_si128(v, 3), lane3));
+    return t;
+}
+
+__attribute__((target("sse2")))
+static void sumSse2(const uint8_t* src, int stride, int width, int height, BlockSums& out) {
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i greenMask = _mm_set1_epi32(0xFF00);
+    const __m128i weightsRG = _mm_set1_epi32(299 | (587 << 16));
+    const __m128i weightsB = _mm_set1_epi32(114);
+    const __m128i magic = _mm_set1_epi32(static_cast<int>(kDiv1000Magic));
+
+    __m128i rAcc = _mm_setzero_si128();
+    __m128i gAcc = _mm_setzero_si128();
+    __m128i bAcc = _mm_setzero_si128();
+    __m128i lumaAcc = _mm_setzero_si128(); // two 64-bit lanes
+
+    const int simdWidth = width & ~3;
+    BlockSums tail;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = src + y * stride;
+        for (int x = 0; x < simdWidth; x += 4) {
+            const __m128i t = packPixelsSse2(row + x * 3);
+            const __m128i r = _mm_and_si128(t, byteMask);
+            const __m128i g = _mm_srli_epi32(_mm_and_si128(t, greenMask), 8);
+            const __m128i b = _mm_srli_epi32(t, 16);
+            rAcc = _mm_add_epi32(rAcc, r);
+            gAcc = _mm_add_epi32(gAcc, g);
+            bAcc = _mm_add_epi32(bAcc, b);
+
+            const __m128i rg = _mm_or_si128(r, _mm_slli_epi32(g, 16));
+            const __m128i luma = _mm_add_epi32(_mm_madd_epi16(rg, weightsRG), _mm_madd_epi16(b, weightsB));
+            const __m128i qEven = _mm_srli_epi64(_mm_mul_epu32(luma, magic), 32);
+            const __m128i qOdd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(luma, 32), magic), 32);
+            lumaAcc = _mm_add_epi64(lumaAcc, _mm_add_epi64(qEven, qOdd));
+        }
+        if (simdWidth < width) {
+            sumScalar(row + simdWidth * 3, stride, width - simdWidth, 1, tail);
+            out.r += tail.r;
+            out.g += tail.g;
+            out.b += tail.b;
+            out.brightness += tail.brightness;
+        }
+    }
+
+    alignas(16) uint32_t lanes[4];
+    alignas(16) uint64_t lumaLanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), rAcc);
+    out.r += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), gAcc);
+    out.g += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), bAcc);
+    out.b += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lumaLanes), lumaAcc);
+    out.brightness += static_cast<uint32_t>(lumaLanes[0] + lumaLanes[1]);
+}
+
+static void sumSse2Entry(const uint8_t* src, int stride, int width, int height, BlockSums& out) {
+    out = BlockSums{};
+    sumSse2(src, stride, width, height, out);
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t horizontalSumAvx2(__m256i v) {
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+}
+
+struct Avx2Accumulators {
+    __m256i r, g, b, luma; // luma holds four 64-bit lanes
+};
+
+// Adds eight pixels, packed one per 32-bit lane as r | g << 8 | b << 16, to the accumulators
+__attribute__((target("avx2")))
+static inline void accumulateAvx2(__m256i t, Avx2Accumulators& acc) {
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i greenMask = _mm256_set1_epi32(0xFF00);
+    const __m256i weightsRG = _mm256_set1_epi32(299 | (587 << 16));
+    const __m256i weightsB = _mm256_set1_epi32(114);
+    const __m256i magic = _mm256_set1_epi32(static_cast<int>(kDiv1000Magic));
+
+    const __m256i r = _mm256_and_si256(t, byteMask);
+    const __m256i g = _mm256_srli_epi32(_mm256_and_si256(t, greenMask), 8);
+    const __m256i b = _mm256_srli_epi32(t, 16);
+    acc.r = _mm256_add_epi32(acc.r, r);
+    acc.g = _mm256_add_epi32(acc.g, g);
+    acc.b = _mm256_add_epi32(acc.b, b);
+
+    const __m256i rg = _mm256_or_si256(r, _mm256_slli_epi32(g, 16));
+    const __m256i luma = _mm256_add_epi32(_mm256_madd_epi16(rg, weightsRG), _mm256_madd_epi16(b, weightsB));
+    const __m256i qEven = _mm256_srli_epi64(_mm256_mul_epu32(luma, magic), 32);
+    const __m256i qOdd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(luma, 32), magic), 32);
+    acc.luma = _mm256_add_epi64(acc.luma, _mm256_add_epi64(qEven, qOdd));
+}
+
+// Loads four pixels from each pointer (16 bytes each) and spreads them one per 32-bit lane
+__attribute__((target("avx2")))
+static inline __m256i loadPixelsAvx2(const uint8_t* lo, const uint8_t* hi) {
+    const __m256i spread = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i loBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo));
+    const __m128i hiBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi));
+    return _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(loBytes), hiBytes, 1), spread);
+}
+
+__attribute__((target("avx2")))
+static void sumAvx2(const uint8_t* src, int stride, int width, int height, BlockSums& out) {
+    Avx2Accumulators acc = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+
+    const int simdWidth = width & ~7;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = src + y * stride;
+        for (int x = 0; x < simdWidth; x += 8) {
+            accumulateAvx2(loadPixelsAvx2(row + x * 3, row + x * 3 + 12), acc);
+        }
+    }
+
+    // A leftover column of four pixels (all of a 4x8 block) is taken two rows at a time
+    int quadColumn = simdWidth;
+    int pairedRows = 0;
+    if (width - simdWidth >= 4) {
+        pairedRows = height & ~1;
+        const uint8_t* column = src + simdWidth * 3;
+        for (int y = 0; y < pairedRows; y += 2) {
+            accumulateAvx2(loadPixelsAvx2(column + y * stride, column + (y + 1) * stride), acc);
+        }
+        quadColumn += 4;
+    }
+
+    alignas(32) uint64_t lumaLanes[4];
+    out.r = horizontalSumAvx2(acc.r);
+    out.g = horizontalSumAvx2(acc.g);
+    out.b = horizontalSumAvx2(acc.b);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lumaLanes), acc.luma);
+    out.brightness = static_cast<uint32_t>(lumaLanes[0] + lumaLanes[1] + lumaLanes[2] + lumaLanes[3]);
+
+    // Whatever the vector loops did not cover: the odd last row of the quad column, then the last 1-3 columns
+    BlockSums rest;
+    if (pairedRows < height && quadColumn > simdWidth) {
+        sumSse2Entry(src + (height - 1) * stride + simdWidth * 3, stride, 4, 1, rest);
+        out.r += rest.r;
+        out.g += rest.g;
+        out.b += rest.b;
+        out.brightness += rest.brightness;
+    }
+    if (quadColumn < width) {
+        sumScalar(src + quadColumn * 3, stride, width - quadColumn, height, rest);
+        out.r += rest.r;
+        out.g += rest.g;
+        out.b += rest.b;
+        out.brightness += rest.brightness;
+    }
+}
+
+#endif // ASCII_KERNELS_X86
+
+std::vector<Kernel> available() {
+    std::vector<Kernel> kernels = {{"scalar", &sumScalar}};
+#ifdef ASCII_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        kernels.push_back({"sse2", &sumSse2Entry});
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back({"avx2", &sumAvx2});
+    }
+#endif
+    return kernels;
+}
+
+const Kernel& best() {
+    static const Kernel kernel = available().back();
+    return kernel;
+}
+
+} // namespace BlockKernels
+} // namespace AsciiVideoFilter
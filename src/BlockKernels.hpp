@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace AsciiVideoFilter {
+
+/**
+ * @brief Per-block accumulators produced by a block kernel.
+ *
+ * brightness is the sum of the per-pixel integer luminance (r*299 + g*587 + b*114) / 1000,
+ * i.e. each pixel is truncated before it is summed, exactly like the original scalar loop.
+ */
+struct BlockSums {
+    uint32_t r = 0;
+    uint32_t g = 0;
+    uint32_t b = 0;
+    uint32_t brightness = 0;
+};
+
+/**
+ * @brief Sums a width x height block of packed RGB24 pixels into out.
+ *
+ * @param src Top-left pixel of the block.
+ * @param stride Bytes between rows (AVFrame linesize).
+ * @param width Block width in pixels.
+ * @param height Block height in pixels.
+ * @param out Accumulators, overwritten.
+ *
+ * SIMD kernels load whole vectors and may read up to BlockKernels::kReadPadding bytes past the
+ * last pixel of a row, so the buffer must be allocated with that much slack at the end.
+ */
+using BlockSumFn = void (*)(const uint8_t* src, int stride, int width, int height, BlockSums& out);
+
+namespace BlockKernels {
+
+constexpr int kReadPadding = 16;
+
+struct Kernel {
+    const char* name;
+    BlockSumFn fn;
+};
+
+// Portable reference implementation. Every other kernel must match it bit for bit.
+void sumScalar(const uint8_t* src, int stride, int width, int height, BlockSums& out);
+
+/**
+ * @brief Fastest kernel the running CPU supports (avx2 > sse2 > scalar). Resolved once.
+ */
+const Kernel& best();
+
+/**
+ * @brief Every kernel usable on the running CPU, scalar first. Used by tests and benchmarks.
+ */
+std::vector<Kernel> available();
+
+} // namespace BlockKernels
+} // namespace AsciiVideoFilter
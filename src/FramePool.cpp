@@ -0,0 +1,138 @@
+#include "FramePool.hpp"
+
+#include <iostream>
+
+extern "C" {
+    #include <libavutil/imgutils.h>
+}
+
+namespace AsciiVideoFilter {
+
+FramePool::FramePool(size_t capacity)
+    : m_free(capacity)
+{
+}
+
+FramePool::~FramePool() {
+    cleanup();
+}
+
+void FramePool::cleanup() {
+    while (AVFrame* frame = m_free.take()) {
+        av_frame_free(&frame);
+    }
+    if (m_bufferPool) {
+        // Buffers still referenced somewhere keep the pool alive until they are unreferenced
+        av_buffer_pool_uninit(&m_bufferPool);
+        m_bufferPool = nullptr;
+    }
+}
+
+int FramePool::init(int width, int height, AVPixelFormat format) {
+    // 32-byte aligned rows, like AsciiRenderer's own frame, plus slack for SIMD reads past the end
+    const int bufferSize = av_image_get_buffer_size(format, width, height, 32);
+    if (bufferSize < 0) {
+        std::cerr << "Error (FramePool::init): Invalid frame size: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, bufferSize) << "\n";
+        return bufferSize;
+    }
+
+    if (m_bufferPool) {
+        av_buffer_pool_uninit(&m_bufferPool);
+    }
+    m_bufferPool = av_buffer_pool_init(bufferSize + 64, nullptr);
+    if (!m_bufferPool) {
+        std::cerr << "Error (FramePool::init): Could not create buffer pool: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, AVERROR(ENOMEM)) << "\n";
+        return AVERROR(ENOMEM);
+    }
+    m_width = width;
+    m_height = height;
+    m_format = format;
+    return 0;
+}
+
+AVFrame* FramePool::acquire() {
+    AVFrame* frame = m_free.take();
+    if (!frame) {
+        frame = av_frame_alloc();
+        if (!frame) {
+            std::cerr << "Error (FramePool::acquire): Could not allocate frame: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, AVERROR(ENOMEM)) << "\n";
+            return nullptr;
+        }
+        m_counters.created.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (m_bufferPool) {
+        frame->buf[0] = av_buffer_pool_get(m_bufferPool);
+        if (!frame->buf[0]) {
+            std::cerr << "Error (FramePool::acquire): Could not get a frame buffer: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, AVERROR(ENOMEM)) << "\n";
+            if (!m_free.put(frame)) {
+                av_frame_free(&frame);
+            }
+            return nullptr;
+        }
+        av_image_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data, m_format, m_width, m_height, 32);
+        frame->width = m_width;
+        frame->height = m_height;
+        frame->format = m_format;
+    }
+
+    m_counters.acquired();
+    return frame;
+}
+
+void FramePool::release(AVFrame* frame) {
+    if (!frame) {
+        return;
+    }
+    av_frame_unref(frame); // Pooled buffers go back to m_bufferPool here
+
+    m_counters.released();
+    if (!m_free.put(frame)) {
+        av_frame_free(&frame); // More frames in flight than the pool was sized for
+    }
+}
+
+PoolStats FramePool::getStats() const {
+    return m_counters.snapshot();
+}
+
+GridPool::GridPool(int rows, int cols, size_t capacity)
+    : m_rows(rows),
+      m_cols(cols),
+      m_free(capacity)
+{
+}
+
+GridPool::~GridPool() {
+    while (AsciiGrid* grid = m_free.take()) {
+        delete grid;
+    }
+}
+
+AsciiGrid* GridPool::acquire() {
+    AsciiGrid* grid = m_free.take();
+    if (!grid) {
+        grid = new AsciiGrid();
+        grid->resize(m_rows, m_cols);
+        m_counters.created.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    m_counters.acquired();
+    return grid;
+}
+
+void GridPool::release(AsciiGrid* grid) {
+    if (!grid) {
+        return;
+    }
+    m_counters.released();
+    if (!m_free.put(grid)) {
+        delete grid;
+    }
+}
+
+PoolStats GridPool::getStats() const {
+    return m_counters.snapshot();
+}
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "AsciiTypes.hpp"
+
+extern "C" {
+    #include <libavutil/buffer.h>
+    #include <libavutil/error.h>
+    #include <libavutil/frame.h>
+    #include <libavutil/pixfmt.h>
+}
+
+namespace AsciiVideoFilter {
+
+/**
+ * @brief Occupancy of a FramePool or GridPool.
+ */
+struct PoolStats {
+    size_t created = 0;   ///< Objects allocated so far; stops growing once the pool has warmed up
+    size_t inUse = 0;     ///< Currently handed out
+    size_t peakInUse = 0; ///< Most ever handed out at once
+};
+
+/**
+ * @class FreeSlots
+ * @brief Fixed number of atomic slots holding the idle objects of a FramePool or GridPool.
+ *
+ * put() claims an empty slot with a compare-exchange and take() empties a full one with an exchange,
+ * so any number of threads can return and take objects without a lock. Each object is in at most one
+ * slot, which rules out ABA. Scans start at slot 0, so the few idle objects of a warmed-up pool sit at
+ * the front.
+ */
+template <typename T>
+class FreeSlots {
+public:
+    explicit FreeSlots(size_t count) : m_slots(new std::atomic<T*>[count]), m_count(count) {
+        for (size_t i = 0; i < m_count; ++i) {
+            m_slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Stores an idle object.
+     * @return false if every slot is taken; the caller keeps the object.
+     */
+    bool put(T* item) {
+        for (size_t i = 0; i < m_count; ++i) {
+            T* expected = nullptr;
+            if (m_slots[i].load(std::memory_order_relaxed) == nullptr &&
+                m_slots[i].compare_exchange_strong(expected, item, std::memory_order_release, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Removes an idle object.
+     * @return The object, or nullptr if there is none.
+     */
+    T* take() {
+        for (size_t i = 0; i < m_count; ++i) {
+            if (m_slots[i].load(std::memory_order_relaxed) != nullptr) {
+                if (T* item = m_slots[i].exchange(nullptr, std::memory_order_acquire)) {
+                    return item;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    std::unique_ptr<std::atomic<T*>[]> m_slots;
+    size_t m_count;
+
+    FreeSlots(const FreeSlots&) = delete;
+    FreeSlots& operator=(const FreeSlots&) = delete;
+};
+
+/**
+ * @brief Lock-free created / in-use / peak counters behind PoolStats.
+ */
+struct PoolCounters {
+    std::atomic<size_t> created{0};
+    std::atomic<size_t> inUse{0};
+    std::atomic<size_t> peakInUse{0};
+
+    void acquired() {
+        const size_t inUseNow = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t peak = peakInUse.load(std::memory_order_relaxed);
+        while (inUseNow > peak && !peakInUse.compare_exchange_weak(peak, inUseNow, std::memory_order_relaxed)) {
+        }
+    }
+
+    void released() { inUse.fetch_sub(1, std::memory_order_relaxed); }
+
+    PoolStats snapshot() const {
+        PoolStats stats;
+        stats.created = created.load(std::memory_order_relaxed);
+        stats.inUse = inUse.load(std::memory_order_relaxed);
+        stats.peakInUse = peakInUse.load(std::memory_order_relaxed);
+        return stats;
+    }
+};
+
+/**
+ * @class FramePool
+ * @brief Recycles AVFrames between pipeline stages so steady-state processing allocates nothing.
+ *
+ * Frame structs come from a lock-free FreeSlots list. After init(), each acquired frame also gets a refcounted
+ * image buffer from an AVBufferPool, so release() (av_frame_unref) hands the buffer straight back
+ * to the pool. Without init(), acquire() returns blank frames for a decoder to fill from its own
+ * buffer pool.
+ *
+ * acquire() and release() may be called from different threads without taking a lock. A frame
+ * released while all `capacity` slots are full is freed instead of kept. Every acquired frame must
+ * be released before the pool is destroyed.
+ */
+class FramePool {
+public:
+    /// Enough for a default-depth queue plus the frames the stages on either side hold
+    static constexpr size_t kDefaultPoolCapacity = 32;
+
+    explicit FramePool(size_t capacity = kDefaultPoolCapacity);
+    ~FramePool();
+
+    /**
+     * @brief Gives acquired frames their own width x height buffer in the given format. Call it
+     * before frames are acquired from more than one thread.
+     * @return 0 on success, or a negative FFmpeg error code.
+     */
+    int init(int width, int height, AVPixelFormat format);
+
+    /**
+     * @brief Takes a frame from the pool, allocating one only if none is free.
+     * @return The frame, or nullptr if allocation failed.
+     */
+    AVFrame* acquire();
+
+    /**
+     * @brief Unreferences the frame's buffers and returns it to the pool.
+     */
+    void release(AVFrame* frame);
+
+    PoolStats getStats() const;
+
+private:
+    char m_errbuf[AV_ERROR_MAX_STRING_SIZE];
+    FreeSlots<AVFrame> m_free;
+    PoolCounters m_counters;
+
+    AVBufferPool* m_bufferPool = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    AVPixelFormat m_format = AV_PIX_FMT_NONE;
+
+    void cleanup();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+};
+
+/**
+ * @class GridPool
+ * @brief Free list of rows x cols AsciiGrids, the grid counterpart of FramePool.
+ *
+ * Acquired grids keep whatever the previous user left in them; AsciiConverter::convert() writes
+ * every cell. acquire() and release() may be called from different threads without taking a lock.
+ */
+class GridPool {
+public:
+    GridPool(int rows, int cols, size_t capacity = FramePool::kDefaultPoolCapacity);
+    ~GridPool();
+
+    /**
+     * @brief Takes a grid from the pool, allocating one only if none is free.
+     */
+    AsciiGrid* acquire();
+
+    /**
+     * @brief Returns a grid obtained from acquire().
+     */
+    void release(AsciiGrid* grid);
+
+    PoolStats getStats() const;
+
+private:
+    int m_rows;
+    int m_cols;
+    FreeSlots<AsciiGrid> m_free;
+    PoolCounters m_counters;
+
+    GridPool(const GridPool&) = delete;
+    GridPool& operator=(const GridPool&) = delete;
+};
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace AsciiVideoFilter {
+
+/**
+ * @class BoundedQueue
+ * @brief Fixed-capacity FIFO used to hand work between pipeline stages.
+ *
+ * push() blocks while the queue is full, which is what gives the pipeline its backpressure:
+ * a fast producer stalls instead of buffering the whole video in memory.
+ * Once close() is called, pushes fail and pops drain whatever is left before failing.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity > 0 ? capacity : 1) {}
+
+    /**
+     * @brief Appends an item, waiting for free space if needed.
+     * @return false if the queue was closed (the item is not consumed in that case).
+     */
+    bool push(T& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest item, waiting for one to arrive if needed.
+     * @return false once the queue is closed and empty.
+     */
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) {
+            return false;
+        }
+        out = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Marks the end of the stream and wakes every waiting producer and consumer.
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<T> m_items;
+    size_t m_capacity;
+    bool m_closed = false;
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+};
+
+/**
+ * @class SpscRing
+ * @brief Fixed-capacity lock-free FIFO between exactly one producer thread and one consumer thread.
+ *
+ * Same contract as BoundedQueue (blocking push/pop, close() then drain), but the hand-off is a pair
+ * of atomic indices into a preallocated ring: no allocation and no lock while items keep flowing.
+ * A side that finds the ring full/empty spins briefly, then parks on a condition variable; the other
+ * side only takes the mutex to wake it when it has announced that it is parked.
+ */
+template <typename T>
+class SpscRing {
+public:
+    /// Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_slots.reset(new T[size]);
+    }
+
+    /**
+     * @brief Producer side: appends an item, waiting for free space if needed.
+     * @return false if the ring was closed (the item is not consumed in that case).
+     */
+    bool push(T& item) {
+        if (m_closed.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (!waitUntil(m_producerParked, [&] { return tail - m_head.load() <= m_mask; })) {
+            return false;
+        }
+        m_slots[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_seq_cst);
+        wake(m_consumerParked);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side: removes the oldest item, waiting for one to arrive if needed.
+     * @return false once the ring is closed and empty.
+     */
+    bool pop(T& out) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (!waitUntil(m_consumerParked, [&] { return m_tail.load() != head; }) && m_tail.load() == head) {
+            return false;
+        }
+        out = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_seq_cst);
+        wake(m_producerParked);
+        return true;
+    }
+
+    /**
+     * @brief Marks the end of the stream and wakes both sides. Safe from any thread.
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed.store(true, std::memory_order_seq_cst);
+        }
+        m_wakeup.notify_all();
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+    /// Items currently queued; only a snapshot when the other side is running
+    size_t size() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+
+private:
+    static constexpr int kSpinCount = 256; ///< Polls before parking; covers short stalls without a syscall
+
+    std::unique_ptr<T[]> m_slots;
+    size_t m_mask = 0;
+    // Producer and consumer indices on separate cache lines so the two threads don't false-share
+    alignas(64) std::atomic<size_t> m_head{0}; ///< Next slot to pop; written by the consumer only
+    alignas(64) std::atomic<size_t> m_tail{0}; ///< Next slot to fill; written by the producer only
+    alignas(64) std::atomic<bool> m_producerParked{false};
+    std::atomic<bool> m_consumerParked{false};
+    std::atomic<bool> m_closed{false};
+    std::mutex m_mutex;                        ///< Only taken to park or to wake a parked side
+    std::condition_variable m_wakeup;
+
+    /**
+     * @brief Waits until ready() or close().
+     * @return true if ready() holds, false if closed first.
+     */
+    template <typename Ready>
+    bool waitUntil(std::atomic<bool>& parked, Ready ready) {
+        for (int spin = 0; spin < kSpinCount; ++spin) {
+            if (ready()) {
+                return true;
+            }
+            if (m_closed.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (spin >= kSpinCount / 2) {
+                std::this_thread::yield();
+            }
+        }
+
+        // Announce the park before re-checking. The flag store, the index loads in ready() and the
+        // other side's index store / flag load are all seq_cst, so either it sees the flag and wakes
+        // us, or its index update is visible to the re-check.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        parked.store(true, std::memory_order_seq_cst);
+        m_wakeup.wait(lock, [&] { return ready() || m_closed.load(std::memory_order_seq_cst); });
+        parked.store(false, std::memory_order_relaxed);
+        return ready();
+    }
+
+    void wake(std::atomic<bool>& parked) {
+        if (parked.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_wakeup.notify_all();
+        }
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+};
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AsciiVideoFilter {
+
+/**
+ * @brief Layout of .agrid files: a sequence of AsciiGrids, stored without rendering them.
+ *
+ * All integers are little-endian.
+ *
+ *   Header (kHeaderSize bytes)
+ *     0  char[4]  magic "AGRD"
+ *     4  u16      version (kVersion)
+ *     6  u16      flags (kFlagColour: frames carry colours; otherwise every cell is white)
+ *     8  u32      rows
+ *    12  u32      cols
+ *    16  i32      frame rate numerator
+ *    20  i32      frame rate denominator
+ *    24  u32      keyframe interval the writer used
+ *    28  u32      reserved (0)
+ *    32  u64      frame count    } 0 until the writer is closed
+ *    40  u64      index offset   }
+ *
+ *   Frame records, back to back from kHeaderSize
+ *     u8   type (kFrameKey or kFrameDelta)
+ *     u8[3] reserved (0)
+ *     u32  payload size in bytes
+ *     i64  pts, in frames of the header's frame rate
+ *     payload
+ *
+ *   Index at the index offset: one kIndexEntrySize entry per frame, in file order
+ *     u64  offset of the frame record
+ *     i64  pts
+ *     u32  flags (kIndexKey for key frames)
+ *     u32  reserved (0)
+ *
+ * Payloads list "coded" cells in row-major order. A key frame codes every cell. A delta frame codes
+ * only the cells that differ from the previous frame and starts with a varint count of them, then a
+ * cell map of (unchanged, changed) varint pairs that ends once the changed runs add up to that count
+ * (the rest of the grid is unchanged). A delta frame with no changes is just the count 0.
+ *
+ * The coded cells then follow as two run-length streams, each covering every coded cell:
+ *   chars:   (varint run, u8 char) pairs
+ *   colours: (varint run, u8 r, u8 g, u8 b) tuples, only with kFlagColour
+ *
+ * Varints are unsigned LEB128.
+ */
+namespace GridFormat {
+
+constexpr char kMagic[4] = {'A', 'G', 'R', 'D'};
+constexpr uint16_t kVersion = 1;
+constexpr uint16_t kFlagColour = 1;
+
+constexpr size_t kHeaderSize = 48;
+constexpr size_t kFrameCountOffset = 32;
+constexpr size_t kFrameHeaderSize = 16;
+constexpr size_t kIndexEntrySize = 24;
+
+constexpr uint8_t kFrameKey = 0;
+constexpr uint8_t kFrameDelta = 1;
+constexpr uint32_t kIndexKey = 1;
+
+inline void putU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+inline void putU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+inline void putU64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline uint16_t getU16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+inline uint32_t getU32(const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+inline uint64_t getU64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+/**
+ * @brief Reads a varint from [in, end) and advances in past it.
+ * @return false if the varint runs past end or is longer than 64 bits.
+ */
+inline bool getVarint(const uint8_t*& in, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && in < end; shift += 7) {
+        const uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace GridFormat
+} // namespace AsciiVideoFilter
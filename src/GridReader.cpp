@@ -0,0 +1,269 @@
+#include "GridReader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+    #include <libavutil/error.h>
+}
+
+namespace AsciiVideoFilter {
+
+GridReader::GridReader() {}
+
+GridReader::~GridReader() {
+    close();
+}
+
+void GridReader::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+    }
+    m_size = 0;
+    m_index.clear();
+    m_currentFrame = -1;
+}
+
+int GridReader::open(const std::string& path) {
+    close();
+    m_path = path;
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        const int ret = AVERROR(errno);
+        std::cerr << "Error (GridReader::open): Could not open " << path << ": " << strerror(errno) << "\n";
+        return ret;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        const int ret = AVERROR(errno);
+        std::cerr << "Error (GridReader::open): Could not stat " << path << ": " << strerror(errno) << "\n";
+        ::close(fd);
+        return ret;
+    }
+    if (static_cast<size_t>(info.st_size) < GridFormat::kHeaderSize) {
+        std::cerr << "Error (GridReader::open): " << path << " is too small to be a grid file.\n";
+        ::close(fd);
+        return AVERROR_INVALIDDATA;
+    }
+
+    m_size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file referenced
+    if (mapped == MAP_FAILED) {
+        const int ret = AVERROR(errno);
+        std::cerr << "Error (GridReader::open): Could not map " << path << ": " << strerror(errno) << "\n";
+        m_size = 0;
+        return ret;
+    }
+    m_data = static_cast<const uint8_t*>(mapped);
+    // Playback mostly walks forward; let the kernel read ahead
+    madvise(mapped, m_size, MADV_SEQUENTIAL);
+
+    const uint8_t* header = m_data;
+    if (std::memcmp(header, GridFormat::kMagic, 4) != 0 || GridFormat::getU16(header + 4) != GridFormat::kVersion) {
+        std::cerr << "Error (GridReader::open): " << path << " is not a version " << GridFormat::kVersion << " grid file.\n";
+        close();
+        return AVERROR_INVALIDDATA;
+    }
+    const uint32_t rows = GridFormat::getU32(header + 8);
+    const uint32_t cols = GridFormat::getU32(header + 12);
+    if (rows == 0 || cols == 0 || static_cast<uint64_t>(rows) * cols > UINT32_MAX) {
+        std::cerr << "Error (GridReader::open): Invalid grid size " << cols << "x" << rows << ".\n";
+        close();
+        return AVERROR_INVALIDDATA;
+    }
+    m_rows = static_cast<int>(rows);
+    m_cols = static_cast<int>(cols);
+    m_colour = GridFormat::getU16(header + 6) & GridFormat::kFlagColour;
+    m_frameRate = AVRational{static_cast<int>(GridFormat::getU32(header + 16)), static_cast<int>(GridFormat::getU32(header + 20))};
+
+    const int ret = loadIndex(GridFormat::getU64(header + GridFormat::kFrameCountOffset),
+                              GridFormat::getU64(header + GridFormat::kFrameCountOffset + 8));
+    if (ret < 0) {
+        close();
+        return ret;
+    }
+
+    m_grid.resize(m_rows, m_cols);
+    m_codedCells.reserve(static_cast<size_t>(m_rows) * m_cols);
+    return 0;
+}
+
+int GridReader::loadIndex(uint64_t frameCount, uint64_t indexOffset) {
+    m_index.clear();
+    if (indexOffset != 0) {
+        if (indexOffset < GridFormat::kHeaderSize || indexOffset > m_size ||
+            frameCount > (m_size - indexOffset) / GridFormat::kIndexEntrySize) {
+            std::cerr << "Error (GridReader::loadIndex): Frame index of " << m_path << " is out of bounds.\n";
+            return AVERROR_INVALIDDATA;
+        }
+        m_index.reserve(frameCount);
+        for (uint64_t i = 0; i < frameCount; ++i) {
+            const uint8_t* entry = m_data + indexOffset + i * GridFormat::kIndexEntrySize;
+            const uint64_t offset = GridFormat::getU64(entry);
+            if (offset < GridFormat::kHeaderSize || offset > indexOffset - GridFormat::kFrameHeaderSize) {
+                std::cerr << "Error (GridReader::loadIndex): Frame " << i << " of " << m_path << " is out of bounds.\n";
+                return AVERROR_INVALIDDATA;
+            }
+            m_index.push_back(IndexEntry{offset, static_cast<int64_t>(GridFormat::getU64(entry + 8)),
+                                         (GridFormat::getU32(entry + 16) & GridFormat::kIndexKey) != 0});
+        }
+        return 0;
+    }
+
+    // The writer didn't get to close(): recover every complete record
+    std::cerr << "Warning (GridReader::loadIndex): " << m_path << " has no frame index (unfinished file?), scanning it.\n";
+    uint64_t offset = GridFormat::kHeaderSize;
+    while (offset + GridFormat::kFrameHeaderSize <= m_size) {
+        const uint8_t* record = m_data + offset;
+        const uint64_t end = offset + GridFormat::kFrameHeaderSize + GridFormat::getU32(record + 4);
+        if (end > m_size) {
+            break;
+        }
+        m_index.push_back(IndexEntry{offset, static_cast<int64_t>(GridFormat::getU64(record + 8)),
+                                     record[0] == GridFormat::kFrameKey});
+        offset = end;
+    }
+    return 0;
+}
+
+int64_t GridReader::findFrame(int64_t pts) const {
+    // pts only grow through the file
+    auto it = std::lower_bound(m_index.begin(), m_index.end(), pts,
+                               [](const IndexEntry& entry, int64_t value) { return entry.pts < value; });
+    return static_cast<int64_t>(it - m_index.begin());
+}
+
+int GridReader::readFrame(int64_t frame) {
+    if (!m_data || frame < 0 || frame >= getFrameCount()) {
+        std::cerr << "Error (GridReader::readFrame): Frame " << frame << " is out of range.\n";
+        return AVERROR(EINVAL);
+    }
+    if (frame == m_currentFrame) {
+        return 0;
+    }
+
+    // Decode forward from the nearest key frame, unless the next delta is all that's needed
+    int64_t first = frame;
+    if (!(frame == m_currentFrame + 1 && m_currentFrame >= 0)) {
+        while (first > 0 && !m_index[first].key) {
+            first--;
+        }
+        if (first > m_currentFrame || frame < m_currentFrame) {
+            m_currentFrame = -1;
+        } else {
+            first = m_currentFrame + 1; // Already between the key frame and the target
+        }
+    }
+
+    for (int64_t i = first; i <= frame; ++i) {
+        const int ret = applyFrame(i);
+        if (ret < 0) {
+            m_currentFrame = -1;
+            return ret;
+        }
+        m_currentFrame = i;
+    }
+    return 0;
+}
+
+int GridReader::applyFrame(int64_t frame) {
+    const uint8_t* record = m_data + m_index[frame].offset;
+    const uint8_t type = record[0];
+    const uint64_t payloadSize = GridFormat::getU32(record + 4);
+    if (m_index[frame].offset + GridFormat::kFrameHeaderSize + payloadSize > m_size ||
+        (type != GridFormat::kFrameKey && type != GridFormat::kFrameDelta)) {
+        std::cerr << "Error (GridReader::applyFrame): Frame " << frame << " is corrupt.\n";
+        return AVERROR_INVALIDDATA;
+    }
+    if (type == GridFormat::kFrameDelta && m_currentFrame != frame - 1) {
+        std::cerr << "Error (GridReader::applyFrame): Frame " << frame << " is a delta with no frame before it.\n";
+        return AVERROR_INVALIDDATA;
+    }
+
+    const uint8_t* in = record + GridFormat::kFrameHeaderSize;
+    const uint8_t* end = in + payloadSize;
+    const uint64_t cells = static_cast<uint64_t>(m_rows) * m_cols;
+    auto corrupt = [&]() {
+        std::cerr << "Error (GridReader::applyFrame): Frame " << frame << " is corrupt.\n";
+        return AVERROR_INVALIDDATA;
+    };
+
+    // Key frames code every cell in order, so positions are implicit
+    const bool key = type == GridFormat::kFrameKey;
+    uint64_t coded = cells;
+    if (!key) {
+        if (!GridFormat::getVarint(in, end, coded) || coded > cells) {
+            return corrupt();
+        }
+        m_codedCells.clear();
+        uint64_t position = 0;
+        while (m_codedCells.size() < coded) {
+            uint64_t unchanged = 0;
+            uint64_t changed = 0;
+            if (!GridFormat::getVarint(in, end, unchanged) || !GridFormat::getVarint(in, end, changed) ||
+                unchanged > cells - position || changed > cells - position - unchanged ||
+                changed > coded - m_codedCells.size()) {
+                return corrupt();
+            }
+            position += unchanged;
+            for (uint64_t i = 0; i < changed; ++i) {
+                m_codedCells.push_back(static_cast<uint32_t>(position++));
+            }
+        }
+    }
+
+    char* chars = m_grid.chars.data();
+    for (uint64_t done = 0; done < coded;) {
+        uint64_t run = 0;
+        if (!GridFormat::getVarint(in, end, run) || in >= end || run == 0 || run > coded - done) {
+            return corrupt();
+        }
+        const char value = static_cast<char>(*in++);
+        if (key) {
+            std::memset(chars + done, value, run);
+        } else {
+            for (uint64_t i = 0; i < run; ++i) {
+                chars[m_codedCells[done + i]] = value;
+            }
+        }
+        done += run;
+    }
+
+    RGB* colours = m_grid.colours.data();
+    if (!m_colour) {
+        // Monochrome files store no colours; every cell shows in white
+        if (key) {
+            std::fill(colours, colours + cells, RGB{255, 255, 255});
+        }
+        return end == in ? 0 : corrupt();
+    }
+    for (uint64_t done = 0; done < coded;) {
+        uint64_t run = 0;
+        if (!GridFormat::getVarint(in, end, run) || end - in < 3 || run == 0 || run > coded - done) {
+            return corrupt();
+        }
+        const RGB value{in[0], in[1], in[2]};
+        in += 3;
+        if (key) {
+            std::fill(colours + done, colours + done + run, value);
+        } else {
+            for (uint64_t i = 0; i < run; ++i) {
+                colours[m_codedCells[done + i]] = value;
+            }
+        }
+        done += run;
+    }
+    return end == in ? 0 : corrupt();
+}
+
+} // namespace AsciiVideoFilter
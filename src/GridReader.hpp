@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AsciiTypes.hpp"
+#include "GridFormat.hpp"
+
+extern "C" {
+    #include <libavutil/rational.h>
+}
+
+namespace AsciiVideoFilter {
+
+/**
+ * @class GridReader
+ * @brief Reads .agrid files written by GridWriter (see GridFormat.hpp).
+ *
+ * The file is memory-mapped and frames are decoded in place into one AsciiGrid owned by the reader,
+ * so reading allocates nothing per frame. Reading the next frame applies a single delta; any other
+ * frame is reached through the index by decoding forward from the nearest key frame before it.
+ * Files whose writer never finished (no index) are indexed by walking the frame records.
+ */
+class GridReader {
+public:
+    GridReader();
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~GridReader();
+
+    /**
+     * @brief Maps the file and loads its header and frame index.
+     * @return 0 on success, or a negative AVERROR on failure (AVERROR_INVALIDDATA if it isn't a
+     *         readable .agrid file).
+     */
+    int open(const std::string& path);
+
+    /**
+     * @brief Unmaps the file. Safe to call more than once.
+     */
+    void close();
+
+    /**
+     * @brief Decodes frame number `frame` (in file order) into getGrid().
+     * @return 0 on success, or a negative AVERROR on failure.
+     */
+    int readFrame(int64_t frame);
+
+    /**
+     * @brief First frame whose pts is at least pts, or getFrameCount() if there is none.
+     */
+    int64_t findFrame(int64_t pts) const;
+
+    /**
+     * @brief The grid decoded by the last successful readFrame().
+     */
+    const AsciiGrid& getGrid() const { return m_grid; }
+
+    // Getters
+    int getRows() const { return m_rows; }
+    int getCols() const { return m_cols; }
+    bool hasColour() const { return m_colour; }
+    AVRational getFrameRate() const { return m_frameRate; }
+    int64_t getFrameCount() const { return static_cast<int64_t>(m_index.size()); }
+    int64_t getPts(int64_t frame) const { return m_index[frame].pts; }
+
+private:
+    struct IndexEntry {
+        uint64_t offset;
+        int64_t pts;
+        bool key;
+    };
+
+    const uint8_t* m_data = nullptr;   ///< Mapped file
+    size_t m_size = 0;
+    std::string m_path;
+
+    int m_rows = 0;
+    int m_cols = 0;
+    bool m_colour = false;
+    AVRational m_frameRate = {0, 1};
+    std::vector<IndexEntry> m_index;
+
+    AsciiGrid m_grid;                   ///< Current frame; stride == cols, so cell i is at index i
+    int64_t m_currentFrame = -1;        ///< Frame m_grid holds, -1 for none
+    std::vector<uint32_t> m_codedCells; ///< Cells a delta codes, in order
+
+    /**
+     * @brief Builds m_index from the index block, or by walking the records if there is none.
+     */
+    int loadIndex(uint64_t frameCount, uint64_t indexOffset);
+
+    /**
+     * @brief Applies one frame record on top of m_grid.
+     */
+    int applyFrame(int64_t frame);
+
+    GridReader(const GridReader&) = delete;
+    GridReader& operator=(const GridReader&) = delete;
+};
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,270 @@
+#include "GridWriter.hpp"
+#include "Stats.hpp"
+#include "Utils.hpp" // AppErrorCode
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace AsciiVideoFilter {
+
+// Large enough that fwrite rarely reaches the kernel more than once per frame
+static constexpr size_t kFileBufferSize = 1 << 20;
+
+static bool sameColour(const RGB& a, const RGB& b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+GridWriter::GridWriter() {}
+
+GridWriter::~GridWriter() {
+    if (m_file) {
+        std::fclose(m_file);
+    }
+}
+
+int GridWriter::open(const std::string& path, int rows, int cols, AVRational frameRate, bool colour) {
+    if (m_file) {
+        std::cerr << "Error (GridWriter::open): " << m_path << " is still open.\n";
+        return AVERROR(EINVAL);
+    }
+    if (rows <= 0 || cols <= 0) {
+        std::cerr << "Error (GridWriter::open): Invalid grid size " << cols << "x" << rows << ".\n";
+        return AVERROR(EINVAL);
+    }
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        const int ret = AVERROR(errno);
+        std::cerr << "Error (GridWriter::open): Could not create " << path << ": " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        return ret;
+    }
+    std::setvbuf(m_file, nullptr, _IOFBF, kFileBufferSize);
+
+    m_path = path;
+    m_rows = rows;
+    m_cols = cols;
+    m_colour = colour;
+    m_offset = 0;
+    m_framesSinceKey = 0;
+    m_keyframeCount = 0;
+    m_index.clear();
+    m_previousValid = false;
+
+    const size_t cells = static_cast<size_t>(rows) * cols;
+    m_recordHeader.reserve(GridFormat::kFrameHeaderSize);
+    m_payload.reserve(cells * 6);
+    m_codedChars.reserve(cells);
+    m_codedColours.reserve(cells);
+
+    // Frame count and index offset stay 0 until close() fills them in
+    std::vector<uint8_t> header;
+    header.insert(header.end(), GridFormat::kMagic, GridFormat::kMagic + 4);
+    GridFormat::putU16(header, GridFormat::kVersion);
+    GridFormat::putU16(header, colour ? GridFormat::kFlagColour : 0);
+    GridFormat::putU32(header, static_cast<uint32_t>(rows));
+    GridFormat::putU32(header, static_cast<uint32_t>(cols));
+    GridFormat::putU32(header, static_cast<uint32_t>(frameRate.num));
+    GridFormat::putU32(header, static_cast<uint32_t>(frameRate.den));
+    GridFormat::putU32(header, static_cast<uint32_t>(m_keyframeInterval));
+    GridFormat::putU32(header, 0);
+    GridFormat::putU64(header, 0);
+    GridFormat::putU64(header, 0);
+    return writeBytes(header.data(), header.size());
+}
+
+void GridWriter::collectAll(const AsciiGrid& grid) {
+    m_codedChars.clear();
+    m_codedColours.clear();
+    for (int row = 0; row < m_rows; ++row) {
+        m_codedChars.insert(m_codedChars.end(), grid.rowChars(row), grid.rowChars(row) + m_cols);
+        if (m_colour) {
+            m_codedColours.insert(m_codedColours.end(), grid.rowColours(row), grid.rowColours(row) + m_cols);
+        }
+    }
+}
+
+void GridWriter::collectChanges(const AsciiGrid& grid) {
+    m_cellMap.clear();
+    m_codedChars.clear();
+    m_codedColours.clear();
+
+    uint64_t unchanged = 0;
+    uint64_t changed = 0;
+    auto flushRuns = [&]() {
+        GridFormat::putVarint(m_cellMap, unchanged);
+        GridFormat::putVarint(m_cellMap, changed);
+        unchanged = 0;
+        changed = 0;
+    };
+
+    for (int row = 0; row < m_rows; ++row) {
+        const char* chars = grid.rowChars(row);
+        const RGB* colours = grid.rowColours(row);
+        const char* previousChars = m_previous.rowChars(row);
+        const RGB* previousColours = m_previous.rowColours(row);
+
+        // Most rows of a typical frame are untouched; settle those with two memcmps
+        if (std::memcmp(chars, previousChars, m_cols) == 0 &&
+            (!m_colour || std::memcmp(colours, previousColours, m_cols * sizeof(RGB)) == 0)) {
+            if (changed > 0) {
+                flushRuns();
+            }
+            unchanged += m_cols;
+            continue;
+        }
+
+        for (int col = 0; col < m_cols; ++col) {
+            const bool differs = chars[col] != previousChars[col] ||
+                                 (m_colour && !sameColour(colours[col], previousColours[col]));
+            if (!differs) {
+                if (changed > 0) {
+                    flushRuns();
+                }
+                unchanged++;
+                continue;
+            }
+            changed++;
+            m_codedChars.push_back(chars[col]);
+            if (m_colour) {
+                m_codedColours.push_back(colours[col]);
+            }
+        }
+    }
+    // Trailing unchanged cells are implied
+    if (changed > 0) {
+        flushRuns();
+    }
+}
+
+void GridWriter::appendRuns() {
+    const size_t count = m_codedChars.size();
+    for (size_t i = 0; i < count;) {
+        size_t run = 1;
+        while (i + run < count && m_codedChars[i + run] == m_codedChars[i]) {
+            run++;
+        }
+        GridFormat::putVarint(m_payload, run);
+        m_payload.push_back(static_cast<uint8_t>(m_codedChars[i]));
+        i += run;
+    }
+
+    if (!m_colour) {
+        return;
+    }
+    for (size_t i = 0; i < count;) {
+        size_t run = 1;
+        while (i + run < count && sameColour(m_codedColours[i + run], m_codedColours[i])) {
+            run++;
+        }
+        GridFormat::putVarint(m_payload, run);
+        m_payload.push_back(m_codedColours[i].r);
+        m_payload.push_back(m_codedColours[i].g);
+        m_payload.push_back(m_codedColours[i].b);
+        i += run;
+    }
+}
+
+int GridWriter::writeFrame(const AsciiGrid& grid, int64_t pts) {
+    if (!m_file) {
+        std::cerr << "Error (GridWriter::writeFrame): Writer not open.\n";
+        return AVERROR(EINVAL);
+    }
+    if (grid.rows != m_rows || grid.cols != m_cols) {
+        std::cerr << "Error (GridWriter::writeFrame): Grid is " << grid.cols << "x" << grid.rows
+                  << ", expected " << m_cols << "x" << m_rows << ".\n";
+        return static_cast<int>(AppErrorCode::APP_ERR_FRAME_CONVERSION_FAILED);
+    }
+    Stats::ScopedTimer timer(Stage::GridWrite);
+
+    const size_t cells = static_cast<size_t>(m_rows) * m_cols;
+    bool key = !m_previousValid || m_framesSinceKey + 1 >= m_keyframeInterval;
+    if (!key) {
+        collectChanges(grid);
+        // A mostly changed frame costs about as much as a key frame, so make it a seek point
+        key = m_codedChars.size() * 2 > cells;
+    }
+
+    m_payload.clear();
+    if (key) {
+        collectAll(grid);
+    } else {
+        GridFormat::putVarint(m_payload, m_codedChars.size());
+        m_payload.insert(m_payload.end(), m_cellMap.begin(), m_cellMap.end());
+    }
+    appendRuns();
+
+    m_recordHeader.clear();
+    m_recordHeader.push_back(key ? GridFormat::kFrameKey : GridFormat::kFrameDelta);
+    m_recordHeader.insert(m_recordHeader.end(), 3, 0);
+    GridFormat::putU32(m_recordHeader, static_cast<uint32_t>(m_payload.size()));
+    GridFormat::putU64(m_recordHeader, static_cast<uint64_t>(pts));
+
+    const uint64_t recordOffset = m_offset;
+    int ret = writeBytes(m_recordHeader.data(), m_recordHeader.size());
+    if (ret < 0 || (ret = writeBytes(m_payload.data(), m_payload.size())) < 0) {
+        return ret;
+    }
+
+    m_index.push_back(IndexEntry{recordOffset, pts, key});
+    m_framesSinceKey = key ? 0 : m_framesSinceKey + 1;
+    m_keyframeCount += key;
+
+    // Deltas are taken against exactly what a reader reconstructs, which is this grid
+    if (m_previous.rows != m_rows || m_previous.cols != m_cols) {
+        m_previous.resize(m_rows, m_cols);
+    }
+    for (int row = 0; row < m_rows; ++row) {
+        std::memcpy(m_previous.rowChars(row), grid.rowChars(row), m_cols);
+        std::memcpy(m_previous.rowColours(row), grid.rowColours(row), m_cols * sizeof(RGB));
+    }
+    m_previousValid = true;
+    return 0;
+}
+
+int GridWriter::close() {
+    if (!m_file) {
+        return 0;
+    }
+
+    const uint64_t indexOffset = m_offset;
+    std::vector<uint8_t> index;
+    index.reserve(m_index.size() * GridFormat::kIndexEntrySize);
+    for (const IndexEntry& entry : m_index) {
+        GridFormat::putU64(index, entry.offset);
+        GridFormat::putU64(index, static_cast<uint64_t>(entry.pts));
+        GridFormat::putU32(index, entry.key ? GridFormat::kIndexKey : 0);
+        GridFormat::putU32(index, 0);
+    }
+    int ret = writeBytes(index.data(), index.size());
+
+    if (ret == 0) {
+        std::vector<uint8_t> trailer;
+        GridFormat::putU64(trailer, m_index.size());
+        GridFormat::putU64(trailer, indexOffset);
+        if (std::fseek(m_file, GridFormat::kFrameCountOffset, SEEK_SET) != 0 ||
+            std::fwrite(trailer.data(), 1, trailer.size(), m_file) != trailer.size()) {
+            ret = AVERROR(errno);
+            std::cerr << "Error (GridWriter::close): Could not update the header of " << m_path << ": " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        }
+    }
+
+    if (std::fclose(m_file) != 0 && ret == 0) {
+        ret = AVERROR(errno);
+        std::cerr << "Error (GridWriter::close): Could not finish " << m_path << ": " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+    }
+    m_file = nullptr;
+    return ret;
+}
+
+int GridWriter::writeBytes(const void* data, size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, m_file) != size) {
+        const int ret = AVERROR(errno ? errno : EIO);
+        std::cerr << "Error (GridWriter::writeBytes): Could not write to " << m_path << ": " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        return ret;
+    }
+    m_offset += size;
+    return 0;
+}
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "AsciiTypes.hpp"
+#include "GridFormat.hpp"
+
+extern "C" {
+    #include <libavutil/error.h>
+    #include <libavutil/rational.h>
+}
+
+namespace AsciiVideoFilter {
+
+/**
+ * @class GridWriter
+ * @brief Writes a sequence of AsciiGrids to a .agrid file (see GridFormat.hpp).
+ *
+ * Frames are stored as key frames or as deltas holding only the cells that changed since the
+ * previous frame, with chars and colours run-length coded. The index written on close() lets a
+ * reader seek to any frame through its nearest preceding key frame. Nothing is rendered or encoded,
+ * so this is far cheaper than an H.264 output of the same grids.
+ */
+class GridWriter {
+public:
+    GridWriter();
+
+    /**
+     * @brief Closes the file if still open (without reporting errors; call close() to see them).
+     */
+    ~GridWriter();
+
+    /**
+     * @brief Creates the file and writes a provisional header.
+     *
+     * @param path Output file.
+     * @param rows Grid rows; every frame must have this layout.
+     * @param cols Grid columns.
+     * @param frameRate Rate pts are counted in.
+     * @param colour Store cell colours; without it a reader shows every cell in white.
+     * @return 0 on success, or a negative AVERROR on failure.
+     */
+    int open(const std::string& path, int rows, int cols, AVRational frameRate, bool colour);
+
+    /**
+     * @brief Appends one grid.
+     *
+     * @param grid Grid of the layout given to open().
+     * @param pts Presentation index in frames; a gap simply keeps the previous grid on screen longer.
+     * @return 0 on success, or a negative AVERROR/AppErrorCode on failure.
+     */
+    int writeFrame(const AsciiGrid& grid, int64_t pts);
+
+    /**
+     * @brief Writes the frame index, fills in the header and closes the file.
+     * @return 0 on success, or a negative AVERROR on failure.
+     */
+    int close();
+
+    /**
+     * @brief Frames between forced key frames (default 120). Takes effect on the next open().
+     *
+     * A delta that changes more than half the cells is written as a key frame anyway, so scene cuts
+     * become seek points too.
+     */
+    void setKeyframeInterval(int frames) { m_keyframeInterval = frames > 0 ? frames : 1; }
+
+    // Getters
+    int64_t getFrameCount() const { return static_cast<int64_t>(m_index.size()); }
+    int64_t getKeyframeCount() const { return m_keyframeCount; }
+    uint64_t getBytesWritten() const { return m_offset; }
+
+private:
+    struct IndexEntry {
+        uint64_t offset;
+        int64_t pts;
+        bool key;
+    };
+
+    char m_errbuf[AV_ERROR_MAX_STRING_SIZE];
+    FILE* m_file = nullptr;
+    std::string m_path;
+    int m_rows = 0;
+    int m_cols = 0;
+    bool m_colour = true;
+    int m_keyframeInterval = 120;
+
+    uint64_t m_offset = 0;              ///< Bytes written so far = offset of the next record
+    int m_framesSinceKey = 0;
+    int64_t m_keyframeCount = 0;
+    std::vector<IndexEntry> m_index;
+
+    AsciiGrid m_previous;               ///< Last frame written, what deltas are taken against
+    bool m_previousValid = false;
+
+    // Per-frame scratch, kept to avoid reallocating
+    std::vector<uint8_t> m_recordHeader;
+    std::vector<uint8_t> m_payload;
+    std::vector<uint8_t> m_cellMap;     ///< Delta cell map: (unchanged, changed) varint pairs
+    std::vector<char> m_codedChars;     ///< Chars of the coded cells, in order
+    std::vector<RGB> m_codedColours;    ///< Colours of the coded cells, in order
+
+    /**
+     * @brief Fills m_cellMap, m_codedChars and m_codedColours with the cells that differ from m_previous.
+     */
+    void collectChanges(const AsciiGrid& grid);
+
+    /**
+     * @brief Collects every cell as coded, for a key frame.
+     */
+    void collectAll(const AsciiGrid& grid);
+
+    /**
+     * @brief Appends the run-length coded char and colour streams of the coded cells to m_payload.
+     */
+    void appendRuns();
+
+    int writeBytes(const void* data, size_t size);
+
+    GridWriter(const GridWriter&) = delete;
+    GridWriter& operator=(const GridWriter&) = delete;
+};
+
+} // namespace AsciiVideoFilter
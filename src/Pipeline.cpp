@@ -0,0 +1,277 @@
+#include "Pipeline.hpp"
+#include "FramePool.hpp"
+#include "FrameQueue.hpp"
+#include "Stats.hpp"
+#include "VideoDecoder.hpp"
+#include "VideoEncoder.hpp"
+#include "AsciiConverter.hpp"
+#include "AsciiRenderer.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+extern "C" {
+    #include <libavutil/frame.h>
+}
+
+namespace AsciiVideoFilter {
+
+// A pooled grid and its position in the input, which becomes its output pts
+struct IndexedGrid {
+    AsciiGrid* grid = nullptr;
+    int64_t index = 0;
+};
+
+Pipeline::Pipeline(VideoDecoder& decoder, AsciiConverter& converter, AsciiRenderer& renderer,
+                   VideoEncoder& encoder, const AppConfig& config)
+    : m_decoder(decoder),
+      m_converter(converter),
+      m_renderer(renderer),
+      m_encoder(encoder),
+      m_config(config)
+{}
+
+int64_t Pipeline::run(ProgressTracker& progress) {
+    return m_config.pipeline ? runThreaded(progress) : runSerial(progress);
+}
+
+int64_t Pipeline::runSerial(ProgressTracker& progress) {
+    AVFrame* inFrame = av_frame_alloc();
+    if (!inFrame) {
+        std::cerr << "Failed to allocate input frame.\n";
+        return AVERROR(ENOMEM);
+    }
+
+    AsciiGrid grid;
+    grid.resize(m_converter.getGridRows(), m_converter.getGridCols());
+    // Last grid rendered, what dedupe compares against; swapped with grid rather than copied
+    AsciiGrid emitted;
+    if (m_config.dedupe) {
+        emitted.resize(m_converter.getGridRows(), m_converter.getGridCols());
+    }
+
+    int64_t frameCount = 0;
+    uint64_t previousHash = 0;
+    AVFrame* renderedFrame = nullptr;
+    bool pendingRepeat = false;
+    while (m_decoder.readFrame(inFrame) && (m_config.maxFrames == -1 || frameCount < m_config.maxFrames)) {
+        m_converter.convert(inFrame, grid);
+        av_frame_unref(inFrame);
+
+        if (m_config.dedupe) {
+            // The hash rejects most changed grids cheaply; a match is confirmed cell by cell
+            const uint64_t hash = grid.hash();
+            if (renderedFrame && hash == previousHash && grid.sameCells(emitted)) {
+                // Same picture as the last encoded frame, which simply stays on screen longer
+                m_repeatedFrames++;
+                pendingRepeat = true;
+                progress.update(frameCount++);
+                continue;
+            }
+            previousHash = hash;
+            pendingRepeat = false;
+        }
+
+        renderedFrame = m_renderer.render(grid, m_config.enableColour);
+        if (!renderedFrame) {
+            std::cerr << "Rendering failed.\n";
+            break;
+        }
+        if (m_config.dedupe) {
+            std::swap(grid, emitted); // convert() writes every cell, so the old one can be reused
+        }
+
+        if (m_encoder.encodeFrame(renderedFrame, frameCount) < 0) {
+            std::cerr << "Encoding frame failed.\n";
+            pendingRepeat = false;
+            break;
+        }
+
+        progress.update(frameCount++);
+    }
+
+    // Repeats running to the end still need a closing frame, or the output would end early.
+    // The renderer's frame still holds the repeated picture.
+    if (pendingRepeat) {
+        m_repeatedFrames--;
+        if (m_encoder.encodeFrame(renderedFrame, frameCount - 1) < 0) {
+            std::cerr << "Encoding frame failed.\n";
+        }
+    }
+    av_frame_free(&inFrame);
+
+    return frameCount;
+}
+
+int64_t Pipeline::runThreaded(ProgressTracker& progress) {
+    const size_t depth = static_cast<size_t>(m_config.queueDepth);
+    SpscRing<AVFrame*> decodedQueue(depth);
+    SpscRing<IndexedGrid> gridQueue(depth);
+    SpscRing<AVFrame*> renderedQueue(depth);
+
+    // Everything handed between stages is recycled, so once the pools have warmed up no stage
+    // allocates per frame. Decoded frames are blank shells the decoder fills from its own pool.
+    // Each pool has room for a full queue on top of its default slots for the stages' own items.
+    const size_t poolCapacity = decodedQueue.capacity() + FramePool::kDefaultPoolCapacity;
+    FramePool decodedPool(poolCapacity);
+    GridPool gridPool(m_converter.getGridRows(), m_converter.getGridCols(), poolCapacity);
+    FramePool renderedPool(poolCapacity);
+
+    std::atomic<bool> failed{false};
+    // Any stage can stop the whole pipeline; closing every queue unblocks all the others.
+    auto abortAll = [&]() {
+        failed = true;
+        decodedQueue.close();
+        gridQueue.close();
+        renderedQueue.close();
+    };
+
+    std::thread decodeThread([&]() {
+        Stats::setThreadName("decode");
+        int64_t decoded = 0;
+        while (!failed && (m_config.maxFrames == -1 || decoded < m_config.maxFrames)) {
+            AVFrame* frame = decodedPool.acquire();
+            if (!frame) {
+                std::cerr << "Failed to allocate input frame.\n";
+                abortAll();
+                break;
+            }
+            if (!m_decoder.readFrame(frame)) {
+                decodedPool.release(frame);
+                break;
+            }
+            if (!decodedQueue.push(frame)) {
+                decodedPool.release(frame);
+                break;
+            }
+            decoded++;
+        }
+        decodedQueue.close();
+    });
+
+    std::thread convertThread([&]() {
+        Stats::setThreadName("convert");
+        AVFrame* frame = nullptr;
+        int64_t index = 0;
+        uint64_t previousHash = 0;
+        IndexedGrid repeat;
+        // Copy of the last grid sent on, what dedupe compares against. The sent grid itself goes
+        // back to the pool once rendered, so this one is held for the whole run.
+        AsciiGrid* emitted = m_config.dedupe ? gridPool.acquire() : nullptr;
+        while (decodedQueue.pop(frame)) {
+            IndexedGrid item{gridPool.acquire(), index++};
+            m_converter.convert(frame, *item.grid);
+            decodedPool.release(frame);
+
+            if (m_config.dedupe) {
+                // The hash rejects most changed grids cheaply; a match is confirmed cell by cell
+                const uint64_t hash = item.grid->hash();
+                if (item.index > 0 && hash == previousHash && item.grid->sameCells(*emitted)) {
+                    // Never rendered or encoded; the previous frame stays on screen longer
+                    m_repeatedFrames++;
+                    gridPool.release(repeat.grid);
+                    repeat = item;
+                    continue;
+                }
+                previousHash = hash;
+                gridPool.release(repeat.grid);
+                repeat.grid = nullptr;
+                // Same layout from the same pool, so this copies without reallocating
+                *emitted = *item.grid;
+            }
+
+            if (!gridQueue.push(item)) {
+                gridPool.release(item.grid);
+                break;
+            }
+        }
+        // Repeats running to the end still need a closing frame, or the output would end early
+        if (repeat.grid && !failed) {
+            m_repeatedFrames--;
+            if (gridQueue.push(repeat)) {
+                repeat.grid = nullptr;
+            }
+        }
+        gridPool.release(repeat.grid);
+        gridPool.release(emitted);
+        gridQueue.close();
+    });
+
+    std::thread renderThread([&]() {
+        Stats::setThreadName("render");
+        bool renderedPoolReady = false;
+        IndexedGrid item;
+        while (gridQueue.pop(item)) {
+            AVFrame* renderedFrame = m_renderer.render(*item.grid, m_config.enableColour);
+            gridPool.release(item.grid);
+            if (!renderedFrame) {
+                std::cerr << "Rendering failed.\n";
+                abortAll();
+                break;
+            }
+
+            // The renderer reuses its output frame, so the encoder gets its own copy.
+            if (!renderedPoolReady) {
+                if (renderedPool.init(renderedFrame->width, renderedFrame->height, static_cast<AVPixelFormat>(renderedFrame->format)) < 0) {
+                    abortAll();
+                    break;
+                }
+                renderedPoolReady = true;
+            }
+            AVFrame* copy = renderedPool.acquire();
+            if (!copy || av_frame_copy(copy, renderedFrame) < 0) {
+                std::cerr << "Failed to copy rendered frame.\n";
+                renderedPool.release(copy);
+                abortAll();
+                break;
+            }
+            av_frame_copy_props(copy, renderedFrame);
+            copy->pts = item.index;
+            if (!renderedQueue.push(copy)) {
+                renderedPool.release(copy);
+                break;
+            }
+        }
+        renderedQueue.close();
+    });
+
+    // Encoding stays on the calling thread.
+    int64_t frameCount = 0;
+    AVFrame* frame = nullptr;
+    while (renderedQueue.pop(frame)) {
+        const int64_t index = frame->pts;
+        if (!failed && m_encoder.encodeFrame(frame, index) < 0) {
+            std::cerr << "Encoding frame failed.\n";
+            abortAll();
+        }
+        renderedPool.release(frame);
+
+        if (!failed) {
+            // Index rather than a count, so frames elided as repeats still show as progress
+            frameCount = index + 1;
+            progress.update(index);
+        }
+    }
+
+    decodeThread.join();
+    convertThread.join();
+    renderThread.join();
+
+    // Release whatever was still queued when a stage bailed out
+    while (decodedQueue.pop(frame)) {
+        decodedPool.release(frame);
+    }
+    IndexedGrid item;
+    while (gridQueue.pop(item)) {
+        gridPool.release(item.grid);
+    }
+
+    m_decodedPoolStats = decodedPool.getStats();
+    m_gridPoolStats = gridPool.getStats();
+    m_renderedPoolStats = renderedPool.getStats();
+    return frameCount;
+}
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "FramePool.hpp" // PoolStats
+#include "Utils.hpp"
+
+#include <cstdint>
+
+namespace AsciiVideoFilter {
+
+class VideoDecoder;
+class AsciiConverter;
+class AsciiRenderer;
+class VideoEncoder;
+
+/**
+ * @class Pipeline
+ * @brief Drives decode -> convert -> render -> encode over a whole video.
+ *
+ * In threaded mode each stage runs on its own thread and hands frames to the next one
+ * through a lock-free SpscRing of AppConfig::queueDepth entries (rounded up to a power of two),
+ * with frames and grids recycled through FramePool/GridPool. Frames stay in decode order end to end
+ * and each stage does the same work as in serial mode, so the output matches a serial run with the
+ * same settings. That includes AppConfig::convertThreads: band-split RGB conversion of sources other
+ * than yuv420p is not exact at band edges in either mode (see AsciiConverter::setThreadCount()).
+ *
+ * With AppConfig::dedupe, a grid identical to the last one sent on (screened by AsciiGrid::hash(),
+ * confirmed with AsciiGrid::sameCells()) is dropped before rendering; every encoded frame carries
+ * its input index as pts, so the previous frame is simply shown for longer (variable frame rate
+ * output).
+ */
+class Pipeline {
+public:
+    /**
+     * @brief Binds the pipeline to already initialized components. Nothing is owned.
+     */
+    Pipeline(VideoDecoder& decoder, AsciiConverter& converter, AsciiRenderer& renderer,
+             VideoEncoder& encoder, const AppConfig& config);
+
+    /**
+     * @brief Processes frames until the input ends, maxFrames is reached or a stage fails.
+     *
+     * @param progress Tracker updated once per input frame.
+     * @return Number of input frames processed, or a negative FFmpeg error if the pipeline could not start.
+     */
+    int64_t run(ProgressTracker& progress);
+
+    /**
+     * @brief With AppConfig::dedupe, frames whose grid repeated the previous one and so were
+     * neither rendered nor encoded.
+     */
+    int64_t getRepeatedFrames() const { return m_repeatedFrames; }
+
+    /**
+     * @brief Occupancy of the threaded pipeline's frame and grid pools after run(). created stays at
+     * about queueDepth + 2 per pool when nothing is allocated per frame.
+     */
+    PoolStats getDecodedPoolStats() const { return m_decodedPoolStats; }
+    PoolStats getGridPoolStats() const { return m_gridPoolStats; }
+    PoolStats getRenderedPoolStats() const { return m_renderedPoolStats; }
+
+private:
+    VideoDecoder& m_decoder;
+    AsciiConverter& m_converter;
+    AsciiRenderer& m_renderer;
+    VideoEncoder& m_encoder;
+    const AppConfig& m_config;
+    int64_t m_repeatedFrames = 0;
+    PoolStats m_decodedPoolStats;
+    PoolStats m_gridPoolStats;
+    PoolStats m_renderedPoolStats;
+
+    int64_t runSerial(ProgressTracker& progress);
+    int64_t runThreaded(ProgressTracker& progress);
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+};
+
+} // namespace AsciiVideoFilter
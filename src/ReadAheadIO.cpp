@@ -0,0 +1,208 @@
+#include "ReadAheadIO.hpp"
+#include "Stats.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+    #include <libavutil/error.h>
+    #include <libavutil/mem.h>
+}
+
+namespace AsciiVideoFilter {
+
+// Size of one read from the source, and of the buffer avio hands the demuxer
+static constexpr int kChunkSize = 64 * 1024;
+// How often a reader blocked on an idle pipe checks whether close() wants it to stop
+static constexpr int kPollMilliseconds = 100;
+
+ReadAheadIO::ReadAheadIO() {}
+
+ReadAheadIO::~ReadAheadIO() {
+    close();
+}
+
+bool ReadAheadIO::isStreamUrl(const std::string& url) {
+    if (url == "-" || url.compare(0, 5, "pipe:") == 0) {
+        return true;
+    }
+    const size_t scheme = url.find("://");
+    if (scheme != std::string::npos) {
+        return url.compare(0, scheme, "file") != 0;
+    }
+    struct stat info;
+    return stat(url.c_str(), &info) == 0 && S_ISFIFO(info.st_mode);
+}
+
+int ReadAheadIO::open(const std::string& url, size_t capacity) {
+    close();
+    m_url = url;
+
+    if (url == "-") {
+        m_fd = STDIN_FILENO;
+        m_ownsFd = false;
+    } else if (url.find("://") == std::string::npos && url.compare(0, 5, "pipe:") != 0) {
+        // Blocks until the writer opens its end, as any reader of a named pipe does
+        m_fd = ::open(url.c_str(), O_RDONLY);
+        if (m_fd < 0) {
+            const int ret = AVERROR(errno);
+            std::cerr << "Error (ReadAheadIO::open): Could not open " << url << ": " << strerror(errno) << "\n";
+            return ret;
+        }
+        m_ownsFd = true;
+    } else {
+        const AVIOInterruptCB interrupt = {interruptCallback, this};
+        const int ret = avio_open2(&m_source, url.c_str(), AVIO_FLAG_READ, &interrupt, nullptr);
+        if (ret < 0) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            std::cerr << "Error (ReadAheadIO::open): Could not open " << url << ": " << av_make_error_string(errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+            return ret;
+        }
+    }
+
+    unsigned char* ioBuffer = static_cast<unsigned char*>(av_malloc(kChunkSize));
+    if (ioBuffer) {
+        // No seek callback: the demuxer sees a non-seekable stream and probes within what it has read
+        m_context = avio_alloc_context(ioBuffer, kChunkSize, 0, this, readPacket, nullptr, nullptr);
+    }
+    if (!m_context) {
+        av_free(ioBuffer);
+        std::cerr << "Error (ReadAheadIO::open): Could not allocate the I/O context.\n";
+        close();
+        return AVERROR(ENOMEM);
+    }
+
+    m_ring.assign(std::max<size_t>(capacity, kChunkSize), 0);
+    m_head = 0;
+    m_fill = 0;
+    m_peakFill = 0;
+    m_bytesRead = 0;
+    m_error = 0;
+    m_stop = false;
+    m_thread = std::thread(&ReadAheadIO::readLoop, this);
+    return 0;
+}
+
+void ReadAheadIO::close() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_spaceReady.notify_all();
+        m_thread.join();
+    }
+    if (m_context) {
+        av_freep(&m_context->buffer);
+        avio_context_free(&m_context);
+    }
+    if (m_source) {
+        avio_closep(&m_source);
+    }
+    if (m_ownsFd && m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd = -1;
+    m_ownsFd = false;
+    m_ring.clear();
+    m_ring.shrink_to_fit();
+}
+
+int ReadAheadIO::readSource(uint8_t* buffer, int size) {
+    if (m_source) {
+        const int ret = avio_read_partial(m_source, buffer, size);
+        return ret == 0 ? AVERROR_EOF : ret;
+    }
+
+    struct pollfd descriptor = {m_fd, POLLIN, 0};
+    const int ready = poll(&descriptor, 1, kPollMilliseconds);
+    if (ready == 0 || (ready < 0 && errno == EINTR)) {
+        return 0; // Nothing yet; check m_stop and try again
+    }
+    if (ready < 0) {
+        return AVERROR(errno);
+    }
+    const ssize_t got = read(m_fd, buffer, size);
+    if (got < 0) {
+        return errno == EINTR || errno == EAGAIN ? 0 : AVERROR(errno);
+    }
+    return got == 0 ? AVERROR_EOF : static_cast<int>(got);
+}
+
+void ReadAheadIO::readLoop() {
+    Stats::setThreadName("read-ahead");
+    std::vector<uint8_t> chunk(kChunkSize);
+
+    while (!m_stop) {
+        size_t space;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_spaceReady.wait(lock, [this] { return m_stop || m_fill < m_ring.size(); });
+            if (m_stop) {
+                break;
+            }
+            space = m_ring.size() - m_fill;
+        }
+
+        const int got = readSource(chunk.data(), static_cast<int>(std::min<size_t>(space, kChunkSize)));
+        if (got == 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (got < 0) {
+            if (got != AVERROR_EOF && got != AVERROR_EXIT) {
+                char errbuf[AV_ERROR_MAX_STRING_SIZE];
+                std::cerr << "Error (ReadAheadIO::readLoop): Reading " << m_url << " failed: " << av_make_error_string(errbuf, AV_ERROR_MAX_STRING_SIZE, got) << "\n";
+            }
+            m_error = got;
+            m_dataReady.notify_all();
+            return;
+        }
+
+        // Only this thread adds data, so the space counted above is still there
+        size_t tail = (m_head + m_fill) % m_ring.size();
+        const size_t first = std::min<size_t>(got, m_ring.size() - tail);
+        std::memcpy(m_ring.data() + tail, chunk.data(), first);
+        std::memcpy(m_ring.data(), chunk.data() + first, got - first);
+        m_fill += got;
+        m_peakFill = std::max(m_peakFill.load(), m_fill);
+        m_bytesRead += got;
+        m_dataReady.notify_all();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_error = AVERROR_EXIT;
+    m_dataReady.notify_all();
+}
+
+int ReadAheadIO::readPacket(void* opaque, uint8_t* buffer, int size) {
+    ReadAheadIO* self = static_cast<ReadAheadIO*>(opaque);
+    std::unique_lock<std::mutex> lock(self->m_mutex);
+    self->m_dataReady.wait(lock, [self] { return self->m_fill > 0 || self->m_error != 0; });
+    if (self->m_fill == 0) {
+        return self->m_error;
+    }
+
+    const size_t count = std::min<size_t>(size, self->m_fill);
+    const size_t first = std::min(count, self->m_ring.size() - self->m_head);
+    std::memcpy(buffer, self->m_ring.data() + self->m_head, first);
+    std::memcpy(buffer + first, self->m_ring.data(), count - first);
+    self->m_head = (self->m_head + count) % self->m_ring.size();
+    self->m_fill -= count;
+    self->m_spaceReady.notify_one();
+    return static_cast<int>(count);
+}
+
+int ReadAheadIO::interruptCallback(void* opaque) {
+    return static_cast<ReadAheadIO*>(opaque)->m_stop ? 1 : 0;
+}
+
+} // namespace AsciiVideoFilter
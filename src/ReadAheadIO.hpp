@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+    #include <libavformat/avio.h>
+}
+
+namespace AsciiVideoFilter {
+
+/**
+ * @class ReadAheadIO
+ * @brief A non-seekable AVIOContext fed by a thread that reads ahead of the demuxer into a bounded
+ * ring buffer.
+ *
+ * For inputs that can't be seeked or reread: stdin ("-"), named pipes and network URLs. The
+ * reader thread keeps draining the source while decoding stalls, so an upstream ffmpeg or a UDP
+ * sender isn't blocked (or dropping datagrams) every time the demuxer pauses. The buffer never
+ * grows past its capacity: when it's full the reader stops until the demuxer catches up.
+ *
+ * stdin and pipes are read with poll() and URLs through avio with an interrupt callback, so
+ * close() returns promptly even when the source has stopped sending.
+ */
+class ReadAheadIO {
+public:
+    ReadAheadIO();
+
+    /**
+     * @brief Stops the reader thread and closes the source.
+     */
+    ~ReadAheadIO();
+
+    /**
+     * @brief Opens the source and starts reading ahead.
+     *
+     * @param url "-" for stdin, a path (named pipe) or an FFmpeg URL (udp://, tcp://, ...).
+     * @param capacity Most bytes buffered ahead of the demuxer.
+     * @return 0 on success, or a negative AVERROR on failure.
+     */
+    int open(const std::string& url, size_t capacity);
+
+    /**
+     * @brief Stops the reader thread and closes the source. Safe to call more than once.
+     */
+    void close();
+
+    /**
+     * @brief The context to put in AVFormatContext::pb (with AVFMT_FLAG_CUSTOM_IO). Owned by this.
+     */
+    AVIOContext* getContext() const { return m_context; }
+
+    // Getters
+    size_t getCapacity() const { return m_ring.size(); }
+    size_t getPeakFill() const { return m_peakFill.load(); }        ///< Fullest the buffer has been
+    uint64_t getBytesRead() const { return m_bytesRead.load(); }    ///< Bytes read from the source so far
+
+    /**
+     * @brief True for the inputs this class is for: "-", named pipes and URLs with a scheme other
+     *        than file:.
+     */
+    static bool isStreamUrl(const std::string& url);
+
+private:
+    int m_fd = -1;                      ///< stdin or pipe source
+    bool m_ownsFd = false;
+    AVIOContext* m_source = nullptr;    ///< URL source
+    AVIOContext* m_context = nullptr;   ///< What the demuxer reads
+    std::string m_url;
+
+    std::vector<uint8_t> m_ring;
+    size_t m_head = 0;                  ///< Next byte the demuxer reads
+    size_t m_fill = 0;                  ///< Bytes buffered
+    // Only the reader thread writes these; atomic so the getters can be called while it runs
+    std::atomic<size_t> m_peakFill{0};
+    std::atomic<uint64_t> m_bytesRead{0};
+    int m_error = 0;                    ///< AVERROR_EOF or the source's error once it has ended
+    std::mutex m_mutex;
+    std::condition_variable m_dataReady;
+    std::condition_variable m_spaceReady;
+    std::atomic<bool> m_stop{false};
+    std::thread m_thread;
+
+    // Reader thread
+    void readLoop();
+    int readSource(uint8_t* buffer, int size);
+
+    // AVIOContext read_packet: blocks until the reader has data or the source has ended
+    static int readPacket(void* opaque, uint8_t* buffer, int size);
+    // Lets close() abort a blocking avio read
+    static int interruptCallback(void* opaque);
+
+    ReadAheadIO(const ReadAheadIO&) = delete;
+    ReadAheadIO& operator=(const ReadAheadIO&) = delete;
+};
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,271 @@
+#include "SegmentConcatenator.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+extern "C" {
+    #include <libavutil/mathematics.h>
+}
+
+namespace AsciiVideoFilter {
+
+SegmentConcatenator::SegmentConcatenator() {}
+
+SegmentConcatenator::~SegmentConcatenator() {
+    cleanup();
+}
+
+void SegmentConcatenator::cleanup() {
+    if (m_segmentContext) {
+        avformat_close_input(&m_segmentContext);
+        m_segmentContext = nullptr;
+    }
+    if (m_audioContext) {
+        avformat_close_input(&m_audioContext);
+        m_audioContext = nullptr;
+    }
+    if (m_outputContext) {
+        if (m_outputContext->pb) {
+            avio_closep(&m_outputContext->pb);
+        }
+        avformat_free_context(m_outputContext);
+        m_outputContext = nullptr;
+    }
+    m_outputVideoStream = nullptr; // Freed with their format contexts
+    m_outputAudioStream = nullptr;
+    m_audioStreamIndex = -1;
+    m_segmentPaths.clear();
+    m_nextSegment = 0;
+    m_segmentStarted = false;
+    m_videoOffset = 0;
+    m_videoEnd = 0;
+    m_anyVideoRead = false;
+}
+
+int SegmentConcatenator::openSegment(const std::string& path) {
+    int ret = avformat_open_input(&m_segmentContext, path.c_str(), nullptr, nullptr);
+    if (ret < 0) {
+        std::cerr << "Error (SegmentConcatenator::openSegment): Could not open segment '" << path << "': " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        return ret;
+    }
+    ret = avformat_find_stream_info(m_segmentContext, nullptr);
+    if (ret < 0) {
+        std::cerr << "Error (SegmentConcatenator::openSegment): Could not read segment '" << path << "': " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        return ret;
+    }
+    // VideoEncoder writes the video stream first
+    if (m_segmentContext->nb_streams < 1 || m_segmentContext->streams[0]->codecpar->codec_type != AVMEDIA_TYPE_VIDEO) {
+        std::cerr << "Error (SegmentConcatenator::openSegment): Segment '" << path << "' has no video stream.\n";
+        return static_cast<int>(AppErrorCode::APP_ERR_DECODER_NOT_FOUND);
+    }
+    m_segmentStarted = false;
+    return 0;
+}
+
+int SegmentConcatenator::openOutput(const std::string& outputPath, const std::string& audioSourcePath) {
+    int ret = avformat_alloc_output_context2(&m_outputContext, nullptr, "mp4", outputPath.c_str());
+    if (ret < 0 || !m_outputContext) {
+        std::cerr << "Error (SegmentConcatenator::openOutput): Could not create output context: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        return ret < 0 ? ret : AVERROR(ENOMEM);
+    }
+
+    // Video parameters come from the first segment, which is left open for copying
+    AVStream* segmentVideo = m_segmentContext->streams[0];
+    m_outputVideoStream = avformat_new_stream(m_outputContext, nullptr);
+    if (!m_outputVideoStream) {
+        return AVERROR(ENOMEM);
+    }
+    ret = avcodec_parameters_copy(m_outputVideoStream->codecpar, segmentVideo->codecpar);
+    if (ret < 0) {
+        return ret;
+    }
+    m_outputVideoStream->codecpar->codec_tag = 0;
+    m_outputVideoStream->time_base = segmentVideo->time_base;
+    m_outputVideoStream->avg_frame_rate = segmentVideo->avg_frame_rate;
+
+    if (!audioSourcePath.empty()) {
+        ret = avformat_open_input(&m_audioContext, audioSourcePath.c_str(), nullptr, nullptr);
+        if (ret >= 0) {
+            ret = avformat_find_stream_info(m_audioContext, nullptr);
+        }
+        if (ret < 0) {
+            std::cerr << "Error (SegmentConcatenator::openOutput): Could not open audio source '" << audioSourcePath << "': " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+            return ret;
+        }
+        for (unsigned i = 0; i < m_audioContext->nb_streams; ++i) {
+            if (m_audioContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+                m_audioStreamIndex = static_cast<int>(i);
+                break;
+            }
+        }
+        if (m_audioStreamIndex < 0) {
+            // Nothing to remux; carry on with video only
+            avformat_close_input(&m_audioContext);
+            m_audioContext = nullptr;
+        } else {
+            m_outputAudioStream = avformat_new_stream(m_outputContext, nullptr);
+            if (!m_outputAudioStream) {
+                return AVERROR(ENOMEM);
+            }
+            ret = avcodec_parameters_copy(m_outputAudioStream->codecpar, m_audioContext->streams[m_audioStreamIndex]->codecpar);
+            if (ret < 0) {
+                return ret;
+            }
+            m_outputAudioStream->codecpar->codec_tag = 0;
+            m_outputAudioStream->time_base = m_audioContext->streams[m_audioStreamIndex]->time_base;
+        }
+    }
+
+    ret = avio_open(&m_outputContext->pb, outputPath.c_str(), AVIO_FLAG_WRITE);
+    if (ret < 0) {
+        std::cerr << "Error (SegmentConcatenator::openOutput): Could not open output file '" << outputPath << "': " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        return ret;
+    }
+    ret = avformat_write_header(m_outputContext, nullptr);
+    if (ret < 0) {
+        std::cerr << "Error (SegmentConcatenator::openOutput): Error writing header: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        return ret;
+    }
+    return 0;
+}
+
+int SegmentConcatenator::readVideoPacket(AVPacket* packet) {
+    while (true) {
+        if (!m_segmentContext) {
+            if (m_nextSegment >= m_segmentPaths.size()) {
+                return AVERROR_EOF;
+            }
+            int ret = openSegment(m_segmentPaths[m_nextSegment++]);
+            if (ret < 0) {
+                return ret;
+            }
+        }
+
+        int ret = av_read_frame(m_segmentContext, packet);
+        if (ret == AVERROR_EOF) {
+            avformat_close_input(&m_segmentContext);
+            m_segmentContext = nullptr;
+            continue;
+        }
+        if (ret < 0) {
+            std::cerr << "Error (SegmentConcatenator::readVideoPacket): Error reading segment: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+            return ret;
+        }
+        if (packet->stream_index != 0) {
+            av_packet_unref(packet);
+            continue;
+        }
+
+        AVStream* stream = m_segmentContext->streams[0];
+        av_packet_rescale_ts(packet, stream->time_base, m_outputVideoStream->time_base);
+        if (!m_segmentStarted) {
+            // Continue the dts sequence exactly where the previous segment stopped. Segments with
+            // B-frames start at a negative dts, which this absorbs.
+            m_videoOffset = m_anyVideoRead ? m_videoEnd - packet->dts : 0;
+            m_segmentStarted = true;
+        }
+        packet->pts += m_videoOffset;
+        packet->dts += m_videoOffset;
+
+        int64_t duration = packet->duration;
+        if (duration <= 0 && stream->avg_frame_rate.num > 0) {
+            duration = av_rescale_q(1, av_inv_q(stream->avg_frame_rate), m_outputVideoStream->time_base);
+        }
+        m_videoEnd = std::max(m_videoEnd, packet->dts + duration);
+        m_anyVideoRead = true;
+        packet->stream_index = m_outputVideoStream->index;
+        return 0;
+    }
+}
+
+int SegmentConcatenator::readAudioPacket(AVPacket* packet) {
+    while (true) {
+        int ret = av_read_frame(m_audioContext, packet);
+        if (ret < 0) {
+            if (ret != AVERROR_EOF) {
+                std::cerr << "Error (SegmentConcatenator::readAudioPacket): Error reading audio: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+            }
+            return ret;
+        }
+        if (packet->stream_index != m_audioStreamIndex) {
+            av_packet_unref(packet);
+            continue;
+        }
+        av_packet_rescale_ts(packet, m_audioContext->streams[m_audioStreamIndex]->time_base, m_outputAudioStream->time_base);
+        packet->stream_index = m_outputAudioStream->index;
+        return 0;
+    }
+}
+
+int SegmentConcatenator::concat(const std::vector<std::string>& segmentPaths, const std::string& audioSourcePath,
+                                const std::string& outputPath) {
+    cleanup();
+    if (segmentPaths.empty()) {
+        std::cerr << "Error (SegmentConcatenator::concat): No segments to concatenate.\n";
+        return static_cast<int>(AppErrorCode::APP_ERR_INVALID_ARG_COUNT);
+    }
+    m_segmentPaths = segmentPaths;
+
+    int ret = openSegment(m_segmentPaths[m_nextSegment++]);
+    if (ret >= 0) {
+        ret = openOutput(outputPath, audioSourcePath);
+    }
+    if (ret < 0) {
+        cleanup();
+        return ret;
+    }
+
+    AVPacket* video = av_packet_alloc();
+    AVPacket* audio = av_packet_alloc();
+    if (!video || !audio) {
+        av_packet_free(&video);
+        av_packet_free(&audio);
+        cleanup();
+        return AVERROR(ENOMEM);
+    }
+
+    int videoRet = readVideoPacket(video);
+    int audioRet = m_audioContext ? readAudioPacket(audio) : AVERROR_EOF;
+    ret = 0;
+    // Merge the two streams by timestamp so the output is interleaved as it is written
+    while (ret >= 0 && (videoRet == 0 || audioRet == 0)) {
+        bool takeVideo = videoRet == 0;
+        if (videoRet == 0 && audioRet == 0) {
+            const int64_t audioTs = audio->dts != AV_NOPTS_VALUE ? audio->dts : audio->pts;
+            takeVideo = av_compare_ts(video->dts, m_outputVideoStream->time_base, audioTs, m_outputAudioStream->time_base) <= 0;
+        }
+
+        ret = av_interleaved_write_frame(m_outputContext, takeVideo ? video : audio);
+        if (ret < 0) {
+            std::cerr << "Error (SegmentConcatenator::concat): Failed to write packet: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+            break;
+        }
+        if (takeVideo) {
+            videoRet = readVideoPacket(video);
+        } else {
+            audioRet = readAudioPacket(audio);
+        }
+    }
+    if (ret >= 0 && videoRet < 0 && videoRet != AVERROR_EOF) {
+        ret = videoRet;
+    }
+    if (ret >= 0 && audioRet < 0 && audioRet != AVERROR_EOF) {
+        ret = audioRet;
+    }
+
+    av_packet_free(&video);
+    av_packet_free(&audio);
+
+    if (ret >= 0) {
+        ret = av_write_trailer(m_outputContext);
+        if (ret < 0) {
+            std::cerr << "Error (SegmentConcatenator::concat): Error writing trailer: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        }
+    }
+
+    cleanup();
+    return ret < 0 ? ret : static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
+}
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include <libavutil/error.h>
+    #include <libavformat/avformat.h>
+    #include <libavcodec/packet.h>
+}
+
+namespace AsciiVideoFilter {
+
+/**
+ * @class SegmentConcatenator
+ * @brief Joins independently encoded video segments into one MP4 and remuxes the source audio once.
+ *
+ * Each segment is a complete MP4 whose video timestamps start at zero (what VideoEncoder writes).
+ * Packets are copied without re-encoding; every segment is shifted so its first dts follows the
+ * previous segment's last packet. Audio is copied straight from the original input, so it is
+ * continuous across segment joins.
+ */
+class SegmentConcatenator {
+public:
+    SegmentConcatenator();
+    ~SegmentConcatenator();
+
+    /**
+     * @brief Writes the concatenation of segmentPaths, in order, to outputPath.
+     *
+     * @param segmentPaths Encoded segments, all with the same video codec parameters.
+     * @param audioSourcePath File whose first audio stream is remuxed into the output, or empty for none.
+     * @param outputPath Path of the MP4 to write.
+     * @return 0 on success, or a negative FFmpeg/AppErrorCode on failure.
+     */
+    int concat(const std::vector<std::string>& segmentPaths, const std::string& audioSourcePath,
+               const std::string& outputPath);
+
+private:
+    char m_errbuf[AV_ERROR_MAX_STRING_SIZE];
+
+    AVFormatContext* m_outputContext = nullptr;
+    AVStream* m_outputVideoStream = nullptr;
+    AVStream* m_outputAudioStream = nullptr;
+
+    // Segment currently being copied
+    std::vector<std::string> m_segmentPaths;
+    size_t m_nextSegment = 0;
+    AVFormatContext* m_segmentContext = nullptr;
+    bool m_segmentStarted = false;    ///< False until the current segment's first packet set m_videoOffset
+    int64_t m_videoOffset = 0;        ///< Added to the current segment's timestamps (output time base)
+    int64_t m_videoEnd = 0;           ///< dts + duration of the last video packet read (output time base)
+    bool m_anyVideoRead = false;
+
+    // Original input, for its audio
+    AVFormatContext* m_audioContext = nullptr;
+    int m_audioStreamIndex = -1;
+
+    int openSegment(const std::string& path);
+    int openOutput(const std::string& outputPath, const std::string& audioSourcePath);
+
+    /**
+     * @brief Next video packet across all segments, timestamps already in the output video time base.
+     * @return 0 on success, AVERROR_EOF after the last segment, or another negative error.
+     */
+    int readVideoPacket(AVPacket* packet);
+
+    /**
+     * @brief Next packet of the source audio stream, timestamps in the output audio time base.
+     * @return 0 on success, AVERROR_EOF at the end of the input, or another negative error.
+     */
+    int readAudioPacket(AVPacket* packet);
+
+    void cleanup();
+
+    SegmentConcatenator(const SegmentConcatenator&) = delete;
+    SegmentConcatenator& operator=(const SegmentConcatenator&) = delete;
+};
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,255 @@
+#include "Stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+extern "C" {
+    #include <libavutil/error.h>
+}
+
+namespace AsciiVideoFilter {
+namespace Stats {
+
+namespace {
+
+constexpr int kStageCount = static_cast<int>(Stage::Count);
+
+// Stats samples go into buffers owned by the thread recording them, so record() never locks.
+// A thread registers its buffers on its first sample; they outlive the thread and are merged
+// when the report is written.
+struct ThreadSamples {
+    std::vector<int64_t> nanoseconds[kStageCount];
+};
+
+constexpr size_t kInitialSamplesPerStage = 4096; // A few minutes of video before the first regrowth
+
+std::atomic<bool> g_enabled{false};
+std::mutex g_threadSamplesMutex; ///< Guards the list itself, taken once per recording thread
+std::vector<std::unique_ptr<ThreadSamples>> g_threadSamples;
+
+// Trace spans go into a buffer allocated when tracing starts. Each span claims a slot with one
+// fetch_add, so threads never wait on each other; spans past the end are only counted.
+struct Span {
+    int64_t startNanoseconds;  ///< Since g_traceStart
+    int64_t durationNanoseconds;
+    int32_t thread;
+    Stage stage;
+};
+
+constexpr size_t kTraceCapacity = size_t(1) << 20; // 24 MiB; about an hour of 30 fps video at ~8 spans per frame
+
+std::atomic<bool> g_tracing{false};
+std::unique_ptr<Span[]> g_spans;
+std::atomic<size_t> g_nextSpan{0};
+std::chrono::steady_clock::time_point g_traceStart;
+
+std::atomic<int32_t> g_nextThreadId{1};
+std::mutex g_threadNamesMutex;
+std::vector<std::pair<int32_t, std::string>> g_threadNames;
+
+// Small sequential ids read better in a trace viewer than hashed std::thread::ids
+int32_t currentThreadId() {
+    thread_local const int32_t id = g_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+ThreadSamples& currentThreadSamples() {
+    thread_local ThreadSamples* samples = nullptr;
+    if (!samples) {
+        std::unique_ptr<ThreadSamples> created(new ThreadSamples());
+        samples = created.get();
+        std::lock_guard<std::mutex> lock(g_threadSamplesMutex);
+        g_threadSamples.push_back(std::move(created));
+    }
+    return *samples;
+}
+
+// Nearest-rank percentile of sorted samples
+int64_t percentile(const std::vector<int64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+double toMilliseconds(int64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1e6;
+}
+
+} // namespace
+
+void setEnabled(bool enable) {
+    g_enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::Decode: return "decode";
+        case Stage::Convert: return "convert";
+        case Stage::ConvertScale: return "convert.scale";
+        case Stage::ConvertAverage: return "convert.average";
+        case Stage::Render: return "render";
+        case Stage::Encode: return "encode";
+        case Stage::EncodeColour: return "encode.colour";
+        case Stage::Mux: return "mux";
+        case Stage::AudioRemux: return "audio.remux";
+        case Stage::GridWrite: return "grid.write";
+        case Stage::Terminal: return "terminal";
+        default: return "unknown";
+    }
+}
+
+void setTracing(bool enable) {
+    if (enable && !g_spans) {
+        g_spans.reset(new Span[kTraceCapacity]);
+    }
+    g_nextSpan.store(0, std::memory_order_relaxed);
+    g_traceStart = std::chrono::steady_clock::now();
+    g_tracing.store(enable, std::memory_order_release);
+}
+
+bool tracing() {
+    return g_tracing.load(std::memory_order_relaxed);
+}
+
+void setThreadName(const char* name) {
+    const int32_t thread = currentThreadId();
+    std::lock_guard<std::mutex> lock(g_threadNamesMutex);
+    g_threadNames.emplace_back(thread, name);
+}
+
+void recordSpan(Stage stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    const int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    record(stage, duration);
+    if (!tracing()) {
+        return;
+    }
+    const size_t slot = g_nextSpan.fetch_add(1, std::memory_order_relaxed);
+    if (slot < kTraceCapacity) {
+        g_spans[slot] = Span{std::chrono::duration_cast<std::chrono::nanoseconds>(start - g_traceStart).count(),
+                             duration, currentThreadId(), stage};
+    }
+}
+
+int writeTrace(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        const int err = AVERROR(errno);
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        std::cerr << "Error (Stats::writeTrace): Could not open " << path << ": " << av_make_error_string(errbuf, AV_ERROR_MAX_STRING_SIZE, err) << "\n";
+        return err;
+    }
+
+    // Segment workers each write their own trace; distinct pids keep them apart if merged
+    const int pid = static_cast<int>(getpid());
+    const size_t claimed = g_nextSpan.load(std::memory_order_acquire);
+    const size_t spans = std::min(claimed, kTraceCapacity);
+    bool first = true;
+    std::fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    {
+        std::lock_guard<std::mutex> lock(g_threadNamesMutex);
+        for (const auto& thread : g_threadNames) {
+            std::fprintf(file, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                         first ? "" : ",", pid, thread.first, thread.second.c_str());
+            first = false;
+        }
+    }
+    for (size_t i = 0; i < spans; ++i) {
+        const Span& span = g_spans[i];
+        std::fprintf(file, "%s\n{\"name\": \"%s\", \"cat\": \"stage\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %d}",
+                     first ? "" : ",", stageName(span.stage), span.startNanoseconds / 1000.0,
+                     span.durationNanoseconds / 1000.0, pid, span.thread);
+        first = false;
+    }
+    std::fprintf(file, "\n]}\n");
+
+    if (std::fclose(file) != 0) {
+        const int err = AVERROR(errno);
+        std::cerr << "Error (Stats::writeTrace): Could not write " << path << "\n";
+        return err;
+    }
+    if (claimed > kTraceCapacity) {
+        std::cerr << "Warning (Stats::writeTrace): Trace buffer full, dropped " << (claimed - kTraceCapacity) << " spans.\n";
+    }
+    return 0;
+}
+
+void record(Stage stage, int64_t nanoseconds) {
+    if (!enabled() || stage >= Stage::Count) {
+        return;
+    }
+    std::vector<int64_t>& samples = currentThreadSamples().nanoseconds[static_cast<int>(stage)];
+    if (samples.capacity() == 0) {
+        samples.reserve(kInitialSamplesPerStage); // Only for the stages this thread actually runs
+    }
+    samples.push_back(nanoseconds);
+}
+
+void reset() {
+    std::lock_guard<std::mutex> lock(g_threadSamplesMutex);
+    for (const auto& samples : g_threadSamples) {
+        for (std::vector<int64_t>& stage : samples->nanoseconds) {
+            stage.clear();
+        }
+    }
+}
+
+int writeJson(const std::string& path, int64_t frames, double wallSeconds) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        const int err = AVERROR(errno);
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        std::cerr << "Error (Stats::writeJson): Could not open " << path << ": " << av_make_error_string(errbuf, AV_ERROR_MAX_STRING_SIZE, err) << "\n";
+        return err;
+    }
+
+    std::fprintf(file, "{\n  \"frames\": %lld,\n  \"wall_seconds\": %.6f,\n  \"fps\": %.3f,\n  \"stages\": [",
+                 static_cast<long long>(frames), wallSeconds, wallSeconds > 0.0 ? frames / wallSeconds : 0.0);
+    for (int i = 0; i < kStageCount; ++i) {
+        std::vector<int64_t> sorted;
+        {
+            std::lock_guard<std::mutex> lock(g_threadSamplesMutex);
+            for (const auto& samples : g_threadSamples) {
+                sorted.insert(sorted.end(), samples->nanoseconds[i].begin(), samples->nanoseconds[i].end());
+            }
+        }
+        std::sort(sorted.begin(), sorted.end());
+        int64_t total = 0;
+        for (int64_t sample : sorted) {
+            total += sample;
+        }
+
+        std::fprintf(file,
+                     "%s\n    {\"name\": \"%s\", \"samples\": %zu, \"total_ms\": %.3f, \"mean_ms\": %.4f, "
+                     "\"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f}",
+                     i == 0 ? "" : ",", stageName(static_cast<Stage>(i)), sorted.size(), toMilliseconds(total),
+                     sorted.empty() ? 0.0 : toMilliseconds(total) / sorted.size(),
+                     toMilliseconds(percentile(sorted, 0.50)), toMilliseconds(percentile(sorted, 0.95)),
+                     toMilliseconds(percentile(sorted, 0.99)), sorted.empty() ? 0.0 : toMilliseconds(sorted.back()));
+    }
+    std::fprintf(file, "\n  ]\n}\n");
+
+    if (std::fclose(file) != 0) {
+        const int err = AVERROR(errno);
+        std::cerr << "Error (Stats::writeJson): Could not write " << path << "\n";
+        return err;
+    }
+    return 0;
+}
+
+} // namespace Stats
+} // namespace AsciiVideoFilter
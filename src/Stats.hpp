@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace AsciiVideoFilter {
+
+/**
+ * @brief Timed parts of the decode -> convert -> render -> encode path.
+ *
+ * Stages nest: Convert contains ConvertScale and ConvertAverage, Encode contains EncodeColour and
+ * the Mux time of the packets it produces, and Decode contains the AudioRemux (and so Mux) time of
+ * audio packets remuxed while demuxing. Converter sub-stages are summed over its band threads, so
+ * with several convert threads they can add up to more than Convert itself.
+ */
+enum class Stage {
+    Decode,         ///< VideoDecoder::readFrame(): demux and decode one frame
+    Convert,        ///< AsciiConverter::convert()
+    ConvertScale,   ///< sws_scale to RGB24 inside convert()
+    ConvertAverage, ///< Block averaging inside convert()
+    Render,         ///< AsciiRenderer::render(): glyph drawing
+    Encode,         ///< VideoEncoder::encodeFrame(): colour conversion, x264, muxing its packets
+    EncodeColour,   ///< RGB24 -> yuv420p sws_scale inside encodeFrame()
+    Mux,            ///< One av_interleaved_write_frame() (video or audio packet)
+    AudioRemux,     ///< One audio packet through the remux handler: timestamp fix-up and muxing
+    GridWrite,      ///< GridWriter::writeFrame(): delta and run-length coding of one grid (.agrid output)
+    Terminal,       ///< TerminalSink::writeFrame(): escape codes for one grid and their write (pacing excluded)
+    Count
+};
+
+/**
+ * @brief Per-stage timing samples and the --stats-json report, plus the --trace timeline.
+ *
+ * Each sample is one frame's time in a stage (one packet's for Stage::Mux and Stage::AudioRemux).
+ * Tracing additionally keeps every ScopedTimer span with its start time and thread, for a
+ * Chrome/Perfetto trace viewer. Any thread may record; samples go into that thread's own buffers
+ * and trace spans into slots claimed atomically, so recording never takes a lock. While both are off,
+ * ScopedTimer doesn't even read the clock, so the timers can stay in the per-frame paths.
+ */
+namespace Stats {
+
+/**
+ * @brief Turns recording on or off. Call before any stage starts running.
+ */
+void setEnabled(bool enable);
+
+bool enabled();
+
+/**
+ * @brief Name used for the stage in the report ("decode", "convert.scale", ...).
+ */
+const char* stageName(Stage stage);
+
+/**
+ * @brief Adds one sample to stage. Ignored while disabled.
+ */
+void record(Stage stage, int64_t nanoseconds);
+
+/**
+ * @brief Drops every sample recorded so far. Must not run while stages are still recording.
+ */
+void reset();
+
+/**
+ * @brief Starts or stops keeping spans for the trace. Call before any stage starts running.
+ *
+ * Starting allocates room for a fixed number of spans up front; spans past that are dropped (and
+ * counted) rather than growing the buffer while stages run.
+ */
+void setTracing(bool enable);
+
+bool tracing();
+
+/**
+ * @brief Adds one span (and, if enabled, one stats sample) to stage.
+ */
+void recordSpan(Stage stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+/**
+ * @brief Names the calling thread in the trace ("decode", "render", ...).
+ */
+void setThreadName(const char* name);
+
+/**
+ * @brief Writes the spans kept so far as Chrome trace_event JSON ("X" events, microseconds).
+ *
+ * Must not run while stages are still recording.
+ * @return 0 on success, or a negative AVERROR on failure.
+ */
+int writeTrace(const std::string& path);
+
+/**
+ * @brief Writes the totals, sample counts and p50/p95/p99/max latency of every stage as JSON.
+ *
+ * Merges every thread's samples, so it must not run while stages are still recording.
+ * @param path File to write.
+ * @param frames Input frames processed.
+ * @param wallSeconds Wall-clock time of the whole run, for the overall frame rate.
+ * @return 0 on success, or a negative AVERROR on failure.
+ */
+int writeJson(const std::string& path, int64_t frames, double wallSeconds);
+
+/**
+ * @brief Records the time between construction and destruction as one sample of a stage and,
+ * while tracing, as one span.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Stage stage)
+        : m_stage(stage),
+          m_active(enabled() || tracing())
+    {
+        if (m_active) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTimer() {
+        if (m_active) {
+            recordSpan(m_stage, m_start, std::chrono::steady_clock::now());
+        }
+    }
+
+private:
+    Stage m_stage;
+    bool m_active;
+    std::chrono::steady_clock::time_point m_start;
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+} // namespace Stats
+} // namespace AsciiVideoFilter
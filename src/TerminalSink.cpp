@@ -0,0 +1,345 @@
+#include "TerminalSink.hpp"
+#include "Stats.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+extern "C" {
+    #include <libavutil/avutil.h>
+    #include <libavutil/error.h>
+    #include <libavutil/mathematics.h>
+}
+
+namespace AsciiVideoFilter {
+
+// A late frame is still shown if nothing has been for this long, so a source that decodes slower
+// than real time plays choppily instead of freezing
+static constexpr double kMaxHoldSeconds = 0.25;
+// Further than this from its due time (a pts jump, or far behind), a frame restarts the clock
+static constexpr double kResyncSeconds = 2.0;
+// Unchanged cells the cursor reprints rather than jumps over; a jump costs 4-5 bytes
+static constexpr int kMaxReprintGap = 4;
+
+static const char kRestore[] = "\x1b[0m\x1b[?25h\r\n";
+
+// What an interrupted run needs to put the cursor back
+static volatile sig_atomic_t g_terminalFd = -1;
+
+static void restoreOnSignal(int sig) {
+    if (g_terminalFd >= 0) {
+        ssize_t ignored = write(g_terminalFd, kRestore, sizeof(kRestore) - 1);
+        (void)ignored;
+    }
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+static void appendNumber(std::string& out, unsigned value) {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        out.push_back(digits[--count]);
+    }
+}
+
+// Index of the nearest xterm 256-colour entry: the 6x6x6 cube (16-231) or the grey ramp (232-255)
+static uint32_t nearestPaletteIndex(const RGB& colour) {
+    static const int kCubeLevels[6] = {0, 95, 135, 175, 215, 255};
+    auto cubeStep = [](int value) { return value < 48 ? 0 : value < 115 ? 1 : (value - 35) / 40; };
+    const int r = cubeStep(colour.r);
+    const int g = cubeStep(colour.g);
+    const int b = cubeStep(colour.b);
+    auto distance = [&colour](int r2, int g2, int b2) {
+        return (colour.r - r2) * (colour.r - r2) + (colour.g - g2) * (colour.g - g2) + (colour.b - b2) * (colour.b - b2);
+    };
+    const int cubeDistance = distance(kCubeLevels[r], kCubeLevels[g], kCubeLevels[b]);
+
+    const int average = (colour.r + colour.g + colour.b) / 3;
+    const int grey = std::min(23, std::max(0, (average - 3) / 10));
+    const int greyLevel = 8 + grey * 10;
+    if (distance(greyLevel, greyLevel, greyLevel) < cubeDistance) {
+        return 232 + grey;
+    }
+    return 16 + 36 * r + 6 * g + b;
+}
+
+TerminalSink::TerminalSink() {}
+
+TerminalSink::~TerminalSink() {
+    finish();
+}
+
+bool TerminalSink::parseColour(const std::string& name, TerminalColour& colour) {
+    if (name == "truecolor") {
+        colour = TerminalColour::TRUECOLOR;
+    } else if (name == "256") {
+        colour = TerminalColour::PALETTE256;
+    } else if (name == "none") {
+        colour = TerminalColour::NONE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int TerminalSink::init(int rows, int cols, TerminalColour colour, AVRational timeBase, AVRational frameRate, int fd) {
+    if (rows <= 0 || cols <= 0 || timeBase.num <= 0 || timeBase.den <= 0) {
+        std::cerr << "Error (TerminalSink::init): Invalid grid size " << cols << "x" << rows << " or time base.\n";
+        return AVERROR(EINVAL);
+    }
+    finish();
+
+    m_fd = fd;
+    m_rows = rows;
+    m_cols = cols;
+    m_colour = colour;
+    m_timeBase = timeBase;
+    m_frameSeconds = frameRate.num > 0 && frameRate.den > 0 ? av_q2d(av_inv_q(frameRate)) : 1.0 / 25.0;
+
+    // Writing past the right edge would wrap and past the bottom would scroll, so clip to the window
+    m_visibleRows = rows;
+    m_visibleCols = cols;
+    struct winsize window;
+    if (isatty(fd) && ioctl(fd, TIOCGWINSZ, &window) == 0 && window.ws_row > 0 && window.ws_col > 0) {
+        m_visibleRows = std::min<int>(rows, window.ws_row);
+        m_visibleCols = std::min<int>(cols, window.ws_col);
+        if (m_visibleRows < rows || m_visibleCols < cols) {
+            std::cerr << "Warning (TerminalSink::init): " << cols << "x" << rows << " grid is larger than the "
+                      << window.ws_col << "x" << window.ws_row << " terminal and will be clipped; use larger blocks.\n";
+        }
+    }
+
+    m_shown.resize(m_visibleRows, m_visibleCols);
+    m_shownValid = false;
+    m_sgrValid = false;
+    m_cursorRow = -1;
+    m_cursorCol = -1;
+    m_clockStarted = false;
+    m_shownFrames = 0;
+    m_droppedFrames = 0;
+    m_bytesWritten = 0;
+    // Room for a full truecolor redraw, the worst case
+    m_out.reserve(static_cast<size_t>(m_visibleRows) * m_visibleCols * 20 + static_cast<size_t>(m_visibleRows) * 12);
+
+    g_terminalFd = fd;
+    std::signal(SIGINT, restoreOnSignal);
+    std::signal(SIGTERM, restoreOnSignal);
+    m_active = true;
+
+    static const char kTakeOver[] = "\x1b[0m\x1b[?25l\x1b[2J";
+    return writeAll(kTakeOver, sizeof(kTakeOver) - 1);
+}
+
+void TerminalSink::finish() {
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+
+    m_out.clear();
+    moveCursor(m_visibleRows - 1, 0);
+    m_out.append(kRestore);
+    writeAll(m_out.data(), m_out.size());
+
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    g_terminalFd = -1;
+}
+
+TerminalSink::Clock::time_point TerminalSink::dueTime(int64_t pts) const {
+    const double offset = (pts - m_ptsStart) * av_q2d(m_timeBase);
+    return m_clockStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(offset));
+}
+
+bool TerminalSink::isLate(int64_t pts) const {
+    if (!m_clockStarted || pts == AV_NOPTS_VALUE) {
+        return false;
+    }
+    const Clock::time_point now = Clock::now();
+    const double behind = std::chrono::duration<double>(now - dueTime(pts)).count();
+    if (behind <= m_frameSeconds || behind > kResyncSeconds) {
+        return false;
+    }
+    return std::chrono::duration<double>(now - m_lastShown).count() < kMaxHoldSeconds;
+}
+
+int TerminalSink::writeFrame(const AsciiGrid& grid, int64_t pts) {
+    if (!m_active) {
+        std::cerr << "Error (TerminalSink::writeFrame): Sink not initialized.\n";
+        return AVERROR(EINVAL);
+    }
+    if (grid.rows != m_rows || grid.cols != m_cols) {
+        std::cerr << "Error (TerminalSink::writeFrame): Grid is " << grid.cols << "x" << grid.rows
+                  << ", expected " << m_cols << "x" << m_rows << ".\n";
+        return AVERROR(EINVAL);
+    }
+
+    if (pts == AV_NOPTS_VALUE) {
+        const int64_t frameDuration = std::max<int64_t>(1, std::llround(m_frameSeconds / av_q2d(m_timeBase)));
+        pts = m_clockStarted ? m_lastPts + frameDuration : 0;
+    }
+    if (isLate(pts)) {
+        m_lastPts = pts;
+        dropFrame();
+        return 0;
+    }
+
+    Clock::time_point due = m_clockStarted ? dueTime(pts) : Clock::now();
+    const double offset = std::chrono::duration<double>(Clock::now() - due).count();
+    if (!m_clockStarted || offset > kResyncSeconds || offset < -kResyncSeconds) {
+        m_clockStart = Clock::now();
+        m_ptsStart = pts;
+        m_clockStarted = true;
+        due = m_clockStart;
+    }
+    m_lastPts = pts;
+    std::this_thread::sleep_until(due);
+
+    Stats::ScopedTimer timer(Stage::Terminal);
+    m_out.clear();
+    appendChanges(grid);
+    const int ret = m_out.empty() ? 0 : writeAll(m_out.data(), m_out.size());
+    m_lastShown = Clock::now();
+    m_shownFrames++;
+    return ret;
+}
+
+uint32_t TerminalSink::colourKey(const RGB& colour) const {
+    switch (m_colour) {
+        case TerminalColour::TRUECOLOR:
+            return static_cast<uint32_t>(colour.r) << 16 | static_cast<uint32_t>(colour.g) << 8 | colour.b;
+        case TerminalColour::PALETTE256:
+            return nearestPaletteIndex(colour);
+        default:
+            return 0;
+    }
+}
+
+void TerminalSink::moveCursor(int row, int col) {
+    if (row == m_cursorRow && col == m_cursorCol) {
+        return;
+    }
+    if (row == m_cursorRow && m_cursorCol >= 0 && col > m_cursorCol) {
+        // Cursor forward (CUF) is shorter than an absolute move
+        m_out.append("\x1b[");
+        appendNumber(m_out, col - m_cursorCol);
+        m_out.push_back('C');
+    } else {
+        m_out.append("\x1b[");
+        appendNumber(m_out, row + 1);
+        m_out.push_back(';');
+        appendNumber(m_out, col + 1);
+        m_out.push_back('H');
+    }
+    m_cursorRow = row;
+    m_cursorCol = col;
+}
+
+void TerminalSink::appendCell(char c, const RGB& colour) {
+    // Only glyphs show the foreground colour, so spaces never need a colour code
+    if (m_colour != TerminalColour::NONE && c != ' ') {
+        const uint32_t key = colourKey(colour);
+        if (!m_sgrValid || key != m_sgr) {
+            if (m_colour == TerminalColour::TRUECOLOR) {
+                m_out.append("\x1b[38;2;");
+                appendNumber(m_out, colour.r);
+                m_out.push_back(';');
+                appendNumber(m_out, colour.g);
+                m_out.push_back(';');
+                appendNumber(m_out, colour.b);
+            } else {
+                m_out.append("\x1b[38;5;");
+                appendNumber(m_out, key);
+            }
+            m_out.push_back('m');
+            m_sgr = key;
+            m_sgrValid = true;
+        }
+    }
+    m_out.push_back(c);
+    // In the last column the terminal defers the wrap, so where the cursor is isn't well defined
+    m_cursorCol = m_cursorCol + 1 < m_visibleCols ? m_cursorCol + 1 : -1;
+}
+
+void TerminalSink::appendChanges(const AsciiGrid& grid) {
+    const bool colour = m_colour != TerminalColour::NONE;
+
+    for (int row = 0; row < m_visibleRows; ++row) {
+        const char* chars = grid.rowChars(row);
+        const RGB* colours = grid.rowColours(row);
+        char* shownChars = m_shown.rowChars(row);
+        RGB* shownColours = m_shown.rowColours(row);
+
+        // Most rows of a typical frame are untouched
+        if (m_shownValid && std::memcmp(chars, shownChars, m_visibleCols) == 0 &&
+            (!colour || std::memcmp(colours, shownColours, m_visibleCols * sizeof(RGB)) == 0)) {
+            continue;
+        }
+
+        for (int col = 0; col < m_visibleCols; ++col) {
+            // Control bytes would be taken as terminal commands; a bad .agrid mustn't reach the tty
+            char c = chars[col];
+            if (static_cast<unsigned char>(c) < 0x20 || static_cast<unsigned char>(c) >= 0x7f) {
+                c = '?';
+            }
+            const bool changed = !m_shownValid || c != shownChars[col] ||
+                                 (colour && c != ' ' && colourKey(colours[col]) != colourKey(shownColours[col]));
+            if (!changed) {
+                continue;
+            }
+
+            // Reprint a short run of unchanged cells instead of jumping, as long as it needs no colour change
+            bool reprint = row == m_cursorRow && m_cursorCol >= 0 && col > m_cursorCol && col - m_cursorCol <= kMaxReprintGap;
+            for (int gap = m_cursorCol; reprint && gap < col; ++gap) {
+                reprint = !colour || shownChars[gap] == ' ' || (m_sgrValid && colourKey(shownColours[gap]) == m_sgr);
+            }
+            if (reprint) {
+                for (int gap = m_cursorCol; gap < col; ++gap) {
+                    appendCell(shownChars[gap], shownColours[gap]);
+                }
+            } else {
+                moveCursor(row, col);
+            }
+
+            appendCell(c, colours[col]);
+            shownChars[col] = c;
+            shownColours[col] = colours[col];
+            if (m_cursorCol < 0) {
+                m_cursorRow = -1;
+            }
+        }
+    }
+    m_shownValid = true;
+}
+
+int TerminalSink::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = write(m_fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const int ret = AVERROR(errno);
+            std::cerr << "Error (TerminalSink::writeAll): Could not write to the terminal: " << strerror(errno) << "\n";
+            return ret;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        m_bytesWritten += static_cast<uint64_t>(written);
+    }
+    return 0;
+}
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "AsciiTypes.hpp"
+
+extern "C" {
+    #include <libavutil/rational.h>
+}
+
+namespace AsciiVideoFilter {
+
+enum class TerminalColour {
+    TRUECOLOR,  ///< 24-bit SGR 38;2;r;g;b
+    PALETTE256, ///< xterm 256-colour SGR 38;5;n, nearest of the 6x6x6 cube and grey ramp
+    NONE        ///< Characters only, in the terminal's own colour
+};
+
+/**
+ * @class TerminalSink
+ * @brief Plays AsciiGrids on a terminal with ANSI escape sequences, in place of rendering and encoding.
+ *
+ * Only cells that changed since the last frame shown are written: the cursor jumps over unchanged
+ * stretches, and a colour code is only emitted when a printed glyph needs a different one (spaces
+ * need none). Each frame goes out in a single write(). Frames are paced to their pts; a frame that
+ * is already more than a frame late is dropped, though never so many in a row that the picture
+ * freezes. Grids larger than the terminal are clipped to it.
+ */
+class TerminalSink {
+public:
+    TerminalSink();
+
+    /**
+     * @brief Restores the terminal if finish() wasn't called.
+     */
+    ~TerminalSink();
+
+    /**
+     * @brief Takes over the terminal: hides the cursor and clears the screen.
+     *
+     * @param rows Grid rows.
+     * @param cols Grid columns.
+     * @param colour How cell colours are written.
+     * @param timeBase Unit of the pts given to writeFrame().
+     * @param frameRate Nominal rate, for frames without a pts and the lateness threshold.
+     * @param fd Terminal to write to.
+     * @return 0 on success, or a negative AVERROR on failure.
+     */
+    int init(int rows, int cols, TerminalColour colour, AVRational timeBase, AVRational frameRate, int fd = 1);
+
+    /**
+     * @brief True if a frame with this pts is already too late to show, so the caller can skip
+     *        producing it. Call dropFrame() for a frame skipped this way.
+     */
+    bool isLate(int64_t pts) const;
+
+    void dropFrame() { m_droppedFrames++; }
+
+    /**
+     * @brief Waits until the frame is due and shows it, or drops it if it's late.
+     *
+     * @param grid Grid of the layout given to init().
+     * @param pts Presentation time in timeBase units, or AV_NOPTS_VALUE for one frame after the last.
+     * @return 0 on success (shown or dropped), or a negative AVERROR if the terminal can't be written.
+     */
+    int writeFrame(const AsciiGrid& grid, int64_t pts);
+
+    /**
+     * @brief Resets colours, shows the cursor again and moves it below the picture.
+     */
+    void finish();
+
+    /**
+     * @brief Parses "truecolor", "256" or "none". Returns false for anything else.
+     */
+    static bool parseColour(const std::string& name, TerminalColour& colour);
+
+    // Getters
+    int64_t getShownFrames() const { return m_shownFrames; }
+    int64_t getDroppedFrames() const { return m_droppedFrames; }
+    uint64_t getBytesWritten() const { return m_bytesWritten; }
+    int getVisibleRows() const { return m_visibleRows; }
+    int getVisibleCols() const { return m_visibleCols; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int m_fd = -1;
+    bool m_active = false;
+    TerminalColour m_colour = TerminalColour::TRUECOLOR;
+    AVRational m_timeBase = {0, 1};
+    double m_frameSeconds = 0.0;
+
+    int m_rows = 0;
+    int m_cols = 0;
+    int m_visibleRows = 0;              ///< Part of the grid that fits on the terminal
+    int m_visibleCols = 0;
+
+    // What the terminal currently shows, which is what the next frame is diffed against
+    AsciiGrid m_shown;
+    bool m_shownValid = false;
+    int m_cursorRow = -1;               ///< -1 when unknown (after the last column of a row)
+    int m_cursorCol = -1;
+    uint32_t m_sgr = 0;                 ///< Colour code in effect, packed as colourKey()
+    bool m_sgrValid = false;
+
+    // Pacing
+    bool m_clockStarted = false;
+    Clock::time_point m_clockStart;
+    int64_t m_ptsStart = 0;
+    int64_t m_lastPts = 0;
+    Clock::time_point m_lastShown;
+
+    std::string m_out;                  ///< Escape codes of the frame being built
+
+    int64_t m_shownFrames = 0;
+    int64_t m_droppedFrames = 0;
+    uint64_t m_bytesWritten = 0;
+
+    Clock::time_point dueTime(int64_t pts) const;
+
+    /**
+     * @brief Appends the escape codes that turn m_shown into grid to m_out, updating m_shown.
+     */
+    void appendChanges(const AsciiGrid& grid);
+
+    void appendCell(char c, const RGB& colour);
+    void moveCursor(int row, int col);
+
+    /**
+     * @brief The colour code a cell needs, packed so equal codes compare equal (the 256-colour index
+     *        in palette mode, the RGB itself in truecolor).
+     */
+    uint32_t colourKey(const RGB& colour) const;
+
+    int writeAll(const char* data, size_t size);
+
+    TerminalSink(const TerminalSink&) = delete;
+    TerminalSink& operator=(const TerminalSink&) = delete;
+};
+
+} // namespace AsciiVideoFilter
@@ -0,0 +1,86 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace AsciiVideoFilter {
+
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    m_workers.reserve(threadCount - 1);
+    for (int thread = 1; thread < threadCount; ++thread) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, thread);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_start.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(int taskCount, TaskFn fn, void* context) {
+    if (taskCount <= 0) {
+        return;
+    }
+    if (m_workers.empty() || taskCount == 1) {
+        // Nothing to hand off; skip the wake-up round trip
+        for (int task = 0; task < taskCount; ++task) {
+            fn(context, task, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_taskFn = fn;
+        m_taskContext = context;
+        m_taskCount = taskCount;
+        m_nextTask.store(0, std::memory_order_relaxed);
+        m_busyWorkers = static_cast<int>(m_workers.size());
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    runTasks(0);
+
+    // Workers that woke late find no tasks left and check out straight away
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+}
+
+void ThreadPool::runTasks(int thread) {
+    for (int task = m_nextTask.fetch_add(1, std::memory_order_relaxed); task < m_taskCount;
+         task = m_nextTask.fetch_add(1, std::memory_order_relaxed)) {
+        m_taskFn(m_taskContext, task, thread);
+    }
+}
+
+void ThreadPool::workerLoop(int thread) {
+    uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+            if (m_stopping) {
+                return;
+            }
+            seenGeneration = m_generation;
+        }
+
+        runTasks(thread);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busyWorkers == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+} // namespace AsciiVideoFilter
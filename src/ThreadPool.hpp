@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace AsciiVideoFilter {
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads for splitting one frame's work into independent tasks.
+ *
+ * parallelFor() hands out task indices from a shared counter, so uneven tasks balance themselves,
+ * and blocks until every task has run. The calling thread works too, so a pool of N threads has
+ * N - 1 workers. Dispatching allocates nothing: the callable is passed by pointer, not wrapped in a
+ * std::function.
+ *
+ * Only one parallelFor() may run at a time.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param threadCount Threads taking part in parallelFor(), including the caller; 0 means one per core.
+     */
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    /// Threads taking part in parallelFor(), including the caller
+    int getThreadCount() const { return static_cast<int>(m_workers.size()) + 1; }
+
+    /**
+     * @brief Runs fn(task, thread) for every task in [0, taskCount) and waits for all of them.
+     *
+     * thread is in [0, getThreadCount()) and identifies the thread running the task (0 is the
+     * caller), for indexing per-thread scratch space. Tasks must not touch each other's output.
+     */
+    template <typename Fn>
+    void parallelFor(int taskCount, Fn&& fn) {
+        using Callable = typename std::remove_reference<Fn>::type;
+        run(taskCount, [](void* context, int task, int thread) { (*static_cast<Callable*>(context))(task, thread); }, &fn);
+    }
+
+private:
+    using TaskFn = void (*)(void* context, int task, int thread);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start;   ///< Workers wait here for the next batch
+    std::condition_variable m_done;    ///< The caller waits here for the workers to finish a batch
+    uint64_t m_generation = 0;         ///< Bumped once per batch
+    int m_busyWorkers = 0;             ///< Workers still inside the current batch
+    bool m_stopping = false;
+
+    // Current batch
+    TaskFn m_taskFn = nullptr;
+    void* m_taskContext = nullptr;
+    int m_taskCount = 0;
+    std::atomic<int> m_nextTask{0};
+
+    void run(int taskCount, TaskFn fn, void* context);
+    void runTasks(int thread);
+    void workerLoop(int thread);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+};
+
+} // namespace AsciiVideoFilter
@@ -1,7 +1,12 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <vector>
 #include "cxxopts.hpp"
+#include "ReadAheadIO.hpp" // ReadAheadIO::isStreamUrl
+#include "TerminalSink.hpp" // TerminalSink::parseColour
 #include "Utils.hpp"
+#include "VideoEncoder.hpp" // EncoderProfiles, VideoEncoder::parseContainer/isPipeOutput
 
 namespace AsciiVideoFilter {
 
@@ -33,7 +38,11 @@ ProgressTracker::ProgressTracker(int totalFrames, double fps, double updateInter
     m_lastUpdate = m_startTime;
 
     if (m_enabled) {
-        std::cout << "Processing " << m_totalFrames << " frames @" << std::fixed << std::setprecision(2) <<  m_frameRate << "fps\n";
+        if (m_totalFrames > 0) {
+            std::cout << "Processing " << m_totalFrames << " frames @" << std::fixed << std::setprecision(2) <<  m_frameRate << "fps\n";
+        } else {
+            std::cout << "Processing a stream of unknown length @" << std::fixed << std::setprecision(2) <<  m_frameRate << "fps\n";
+        }
         std::cout << "Progress updates every " << m_updateInterval << " seconds\n";
         std::cout << std::string(60, '-') << std::endl;
     }
@@ -50,7 +59,14 @@ void ProgressTracker::update(int frameNumber) {
     bool shouldUpdate = (timeSinceLastUpdate >= m_updateInterval) ||
         (m_processedFrames == m_totalFrames);  // Always show final frame
 
-    if (shouldUpdate) {
+    if (shouldUpdate && m_totalFrames <= 0) {
+        // Length unknown (a live stream or pipe): no bar or ETA
+        auto elapsed = std::chrono::duration<double>(now - m_startTime).count();
+        std::cout << "\rFrames: " << m_processedFrames << " "
+            << "FPS: " << std::fixed << std::setprecision(1) << m_processedFrames / elapsed << " "
+            << "Elapsed: " << formatTime(elapsed) << std::flush;
+        m_lastUpdate = now;
+    } else if (shouldUpdate) {
         auto elapsed = std::chrono::duration<double>(now - m_startTime).count();
         double actualFps = m_processedFrames / elapsed;
         double percentage = (static_cast<double>(m_processedFrames) / m_totalFrames) * 100.0;
@@ -94,7 +110,11 @@ void ProgressTracker::finish() {
 
     std::cout << "\n" << std::string(60, '-') << std::endl;
     std::cout << "Final Statistics:\n";
-    std::cout << "  Frames processed: " << m_processedFrames << "/" << m_totalFrames << "\n";
+    std::cout << "  Frames processed: " << m_processedFrames;
+    if (m_totalFrames > 0) {
+        std::cout << "/" << m_totalFrames;
+    }
+    std::cout << "\n";
     std::cout << "  Total time: " << formatTime(elapsed) << "\n";
     std::cout << "  Average FPS: " << std::fixed << std::setprecision(2) << actualFps << "\n";
     std::cout << std::string(60, '-') << std::endl;
@@ -109,13 +129,31 @@ AppConfig parseArguments(int argc, const char* argv[]) {
     cxxopts::Options options("ascii-video-filter", "Convert videos to ASCII art");
 
     options.add_options()
-        ("i,input", "Input video file", cxxopts::value<std::string>())
-        ("o,output", "Output video file", cxxopts::value<std::string>())
+        ("i,input", "Input video file, - for stdin, a named pipe or an FFmpeg URL (udp://, tcp://, ...)",
+            cxxopts::value<std::string>())
+        ("o,output", "Output video file, - for stdout, or a .agrid file to store the ASCII grids themselves (no rendering or encoding)",
+            cxxopts::value<std::string>())
+        ("from-grid", "Render and encode the grids stored in this .agrid file instead of an input video "
+            "(re-render with another font, block size or colour mode without decoding again)",
+            cxxopts::value<std::string>())
+        ("terminal", "Play in this terminal with ANSI escape codes instead of writing an output file, "
+            "in truecolor, 256 or none colours (no audio)",
+            cxxopts::value<std::string>()->implicit_value("truecolor"))
         ("f,font", "Path to TTF font file", cxxopts::value<std::string>()->default_value(config.fontPath))
         ("p,preset", "Character preset (standard, detailed, binary)", cxxopts::value<std::string>()->default_value(config.charsetPreset))
         ("c,charset", "Custom character set (overrides preset)", cxxopts::value<std::string>())
+        ("convert-mode", "Block averaging path: rgb (any input), yuv (reads 8-bit planar YUV directly), scale (swscale straight to grid size)",
+            cxxopts::value<std::string>()->default_value(config.convertMode))
+        ("scale-filter", "Filter for --convert-mode scale (area, bilinear, bicubic, fast_bilinear, point, gauss, lanczos, spline)",
+            cxxopts::value<std::string>()->default_value(config.scaleFilter))
+        ("render-format", "Renderer output: yuv (yuv420p, fed to the encoder as is) or rgb (rgb24, converted by the encoder)",
+            cxxopts::value<std::string>()->default_value(config.renderFormat))
         ("max-frames", "Maximum frames to process (-1 for all)", 
             cxxopts::value<int>()->default_value(std::to_string(-1)))
+        ("start", "Start time ([HH:]MM:SS[.frac] or seconds); seeks to the keyframe before it",
+            cxxopts::value<std::string>())
+        ("end", "End time ([HH:]MM:SS[.frac] or seconds)",
+            cxxopts::value<std::string>())
         ("block-width", "Character block width in pixels", 
             cxxopts::value<int>()->default_value(std::to_string(config.blockWidth)))
         ("block-height", "Character block height in pixels",
@@ -124,6 +162,46 @@ AppConfig parseArguments(int argc, const char* argv[]) {
         ("no-colour", "Disable colour video")
         ("v,verbose", "Enable verbose output")
         ("no-progress", "Disable progress output")
+        ("decode-threads", "Video decoder threads (0 = one per core)",
+            cxxopts::value<int>()->default_value(std::to_string(config.decodeThreads)))
+        ("decode-thread-type", "Video decoder threading: auto (frame and slice), frame, slice",
+            cxxopts::value<std::string>()->default_value(config.decodeThreadType))
+        ("convert-threads", "Threads converting bands of block rows in rgb and yuv convert modes (0 = one per core, 1 = single-threaded). "
+            "In rgb mode, sources other than yuv420p can differ slightly at band edges",
+            cxxopts::value<int>()->default_value(std::to_string(config.convertThreads)))
+        ("render-threads", "Threads rendering bands of grid rows (0 = one per core, 1 = single-threaded)",
+            cxxopts::value<int>()->default_value(std::to_string(config.renderThreads)))
+        ("motion-skip", "Recompute only grid cells the decoder's motion vectors show changing (H.264/MPEG without B-frames, one reference frame; rgb and yuv convert modes)")
+        ("dedupe", "Skip rendering and encoding frames whose ASCII grid repeats the previous one (variable frame rate output)")
+        ("container", "Output container: mp4, fmp4 (fragmented, playable while written), mpegts, or auto "
+            "(mpegts for .ts/.m2ts, fmp4 for - and pipes, otherwise mp4)",
+            cxxopts::value<std::string>()->default_value(config.container))
+        ("encoder-profile", "x264 settings: throughput (fastest), balanced, archival (smallest, slowest)",
+            cxxopts::value<std::string>()->default_value(config.encoderProfile))
+        ("encoder-threads", "x264 threads, overriding the profile (-1 = profile default, 0 = auto)",
+            cxxopts::value<int>()->default_value(std::to_string(config.encoderThreads)))
+        ("segments", "Split the input at keyframes into N segments, each encoded by its own worker process",
+            cxxopts::value<int>()->default_value(std::to_string(config.segments)))
+        ("segment-index", "Encode only this segment of --segments N to <output>.part<index>.mp4 (worker mode; "
+            "lets other machines sharing the filesystem take segments)",
+            cxxopts::value<int>()->default_value(std::to_string(config.segmentIndex)))
+        ("concat-only", "With --segments: join existing segment files into the output without spawning workers")
+        ("probesize", "Bytes of input read to detect its format (0 = FFmpeg's default)",
+            cxxopts::value<int64_t>()->default_value(std::to_string(config.probeSize)))
+        ("analyzeduration", "Microseconds of input read to find stream parameters (0 = FFmpeg's default); "
+            "lower it to start live streams sooner",
+            cxxopts::value<int64_t>()->default_value(std::to_string(config.analyzeDuration)))
+        ("read-ahead", "MiB buffered ahead of the decoder for stdin, pipe and URL inputs",
+            cxxopts::value<int>()->default_value(std::to_string(config.readAheadMiB)))
+        ("no-pipeline", "Run decode, convert, render and encode serially on one thread")
+        ("queue-depth", "Frames buffered between pipeline stages",
+            cxxopts::value<int>()->default_value(std::to_string(config.queueDepth)))
+        ("stats-json", "Time each stage and write per-stage totals and p50/p95/p99 frame latency as JSON to this file "
+            "(segment workers write <file>.part<index>)",
+            cxxopts::value<std::string>())
+        ("trace", "Record a span per frame per stage and write them as Chrome/Perfetto trace_event JSON to this file "
+            "(segment workers write <file>.part<index>)",
+            cxxopts::value<std::string>())
         ("h,help", "Print usage information");
 
     try {
@@ -135,37 +213,89 @@ AppConfig parseArguments(int argc, const char* argv[]) {
         }
 
         // Required arguments
-        if (!result.count("input")) {
-            std::cerr << "Error: Input file is required\n";
+        if (!result.count("input") && !result.count("from-grid")) {
+            std::cerr << "Error: Input file (or --from-grid) is required\n";
             std::cerr << options.help() << std::endl;
             std::exit(1);
         }
 
-        if (!result.count("output")) {
+        if (!result.count("output") && !result.count("terminal")) {
             std::cerr << "Error: Output file is required\n";
             std::cerr << options.help() << std::endl;
             std::exit(1);
         }
 
-        config.inputPath = result["input"].as<std::string>();
-        config.outputPath = result["output"].as<std::string>();
+        if (result.count("input")) {
+            config.inputPath = result["input"].as<std::string>();
+        }
+        if (result.count("from-grid")) {
+            config.fromGridPath = result["from-grid"].as<std::string>();
+        }
+        if (result.count("output")) {
+            config.outputPath = result["output"].as<std::string>();
+        }
+        if (result.count("terminal")) {
+            config.terminalColour = result["terminal"].as<std::string>();
+        }
         config.fontPath = result["font"].as<std::string>();
         config.charsetPreset = result["preset"].as<std::string>();
+        config.convertMode = result["convert-mode"].as<std::string>();
+        config.scaleFilter = result["scale-filter"].as<std::string>();
+        config.renderFormat = result["render-format"].as<std::string>();
         config.maxFrames = result["max-frames"].as<int>();
+        if (result.count("start") && !parseTimestamp(result["start"].as<std::string>(), config.startSeconds)) {
+            std::cerr << "Error: Invalid start time '" << result["start"].as<std::string>() << "'\n";
+            std::exit(1);
+        }
+        if (result.count("end") && !parseTimestamp(result["end"].as<std::string>(), config.endSeconds)) {
+            std::cerr << "Error: Invalid end time '" << result["end"].as<std::string>() << "'\n";
+            std::exit(1);
+        }
         config.blockWidth = result["block-width"].as<int>();
         config.blockHeight = result["block-height"].as<int>();
         config.enableAudio = !result.count("no-audio");
         config.enableColour = !result.count("no-colour");
         config.verbose = result.count("verbose");
         config.showProgress = !result.count("no-progress");
+        config.decodeThreads = result["decode-threads"].as<int>();
+        config.decodeThreadType = result["decode-thread-type"].as<std::string>();
+        config.convertThreads = result["convert-threads"].as<int>();
+        config.renderThreads = result["render-threads"].as<int>();
+        config.motionSkip = result.count("motion-skip");
+        config.dedupe = result.count("dedupe");
+        config.encoderProfile = result["encoder-profile"].as<std::string>();
+        config.container = result["container"].as<std::string>();
+        config.encoderThreads = result["encoder-threads"].as<int>();
+        config.segments = result["segments"].as<int>();
+        config.segmentIndex = result["segment-index"].as<int>();
+        config.concatOnly = result.count("concat-only");
+        config.probeSize = result["probesize"].as<int64_t>();
+        config.analyzeDuration = result["analyzeduration"].as<int64_t>();
+        config.readAheadMiB = result["read-ahead"].as<int>();
+        config.pipeline = !result.count("no-pipeline");
+        config.queueDepth = result["queue-depth"].as<int>();
+        if (result.count("stats-json")) {
+            config.statsJsonPath = result["stats-json"].as<std::string>();
+        }
+        if (result.count("trace")) {
+            config.tracePath = result["trace"].as<std::string>();
+        }
 
         if (result.count("charset")) {
             config.customCharset = result["charset"].as<std::string>();
         }
 
         // Validation
-        if (!std::filesystem::exists(config.inputPath)) {
-            std::cerr << "Error: Input file does not exist: " << config.inputPath << std::endl;
+        if (!config.inputPath.empty() && !config.fromGridPath.empty()) {
+            std::cerr << "Error: --input and --from-grid can't be combined\n";
+            std::exit(1);
+        }
+
+        // Streams ("-", URLs) are only known to exist once opened
+        const std::string& sourcePath = config.fromGridPath.empty() ? config.inputPath : config.fromGridPath;
+        const bool streamInput = config.fromGridPath.empty() && ReadAheadIO::isStreamUrl(config.inputPath);
+        if (!streamInput && !std::filesystem::exists(sourcePath)) {
+            std::cerr << "Error: Input file does not exist: " << sourcePath << std::endl;
             std::exit(1);
         }
 
@@ -179,6 +309,138 @@ AppConfig parseArguments(int argc, const char* argv[]) {
             std::exit(1);
         }
 
+        if (config.convertMode != "rgb" && config.convertMode != "yuv" && config.convertMode != "scale") {
+            std::cerr << "Error: Invalid convert mode '" << config.convertMode << "'. Valid modes: rgb yuv scale\n";
+            std::exit(1);
+        }
+
+        if (config.renderFormat != "rgb" && config.renderFormat != "yuv") {
+            std::cerr << "Error: Invalid render format '" << config.renderFormat << "'. Valid formats: rgb yuv\n";
+            std::exit(1);
+        }
+
+        const std::vector<std::string> validFilters = {"area", "bilinear", "bicubic", "fast_bilinear", "point", "gauss", "lanczos", "spline"};
+        if (std::find(validFilters.begin(), validFilters.end(), config.scaleFilter) == validFilters.end()) {
+            std::cerr << "Error: Invalid scale filter '" << config.scaleFilter << "'. Valid filters: ";
+            for (const auto& name : validFilters) {
+                std::cerr << name << " ";
+            }
+            std::cerr << std::endl;
+            std::exit(1);
+        }
+
+        if (config.decodeThreads < 0) {
+            std::cerr << "Error: Decode threads must be 0 (auto) or positive\n";
+            std::exit(1);
+        }
+
+        if (config.decodeThreadType != "auto" && config.decodeThreadType != "frame" && config.decodeThreadType != "slice") {
+            std::cerr << "Error: Invalid decode thread type '" << config.decodeThreadType << "'. Valid types: auto frame slice\n";
+            std::exit(1);
+        }
+
+        if (!EncoderProfiles::find(config.encoderProfile)) {
+            std::cerr << "Error: Invalid encoder profile '" << config.encoderProfile << "'. Valid profiles: ";
+            for (const auto& profile : EncoderProfiles::all()) {
+                std::cerr << profile.name << " ";
+            }
+            std::cerr << std::endl;
+            std::exit(1);
+        }
+
+        if (config.convertThreads < 0) {
+            std::cerr << "Error: Convert threads must be 0 (auto) or positive\n";
+            std::exit(1);
+        }
+
+        if (config.renderThreads < 0) {
+            std::cerr << "Error: Render threads must be 0 (auto) or positive\n";
+            std::exit(1);
+        }
+
+        if (config.encoderThreads < -1) {
+            std::cerr << "Error: Encoder threads must be -1 (profile default), 0 (auto) or positive\n";
+            std::exit(1);
+        }
+
+        if (config.segments <= 0) {
+            std::cerr << "Error: Segment count must be positive\n";
+            std::exit(1);
+        }
+
+        if (config.segmentIndex < -1 || config.segmentIndex >= config.segments) {
+            std::cerr << "Error: Segment index must be between 0 and " << config.segments - 1 << "\n";
+            std::exit(1);
+        }
+
+        if (config.segments > 1 && config.maxFrames != -1) {
+            std::cerr << "Error: --max-frames can't be combined with --segments\n";
+            std::exit(1);
+        }
+
+        if (config.endSeconds >= 0.0 && config.endSeconds <= config.startSeconds) {
+            std::cerr << "Error: End time must be after start time\n";
+            std::exit(1);
+        }
+
+        if (config.segments > 1 && (config.startSeconds > 0.0 || config.endSeconds >= 0.0)) {
+            std::cerr << "Error: --start/--end can't be combined with --segments\n";
+            std::exit(1);
+        }
+
+        ContainerFormat container;
+        if (!VideoEncoder::parseContainer(config.container, config.outputPath, container)) {
+            std::cerr << "Error: Invalid container '" << config.container << "'. Valid containers: auto mp4 fmp4 mpegts\n";
+            std::exit(1);
+        }
+
+        if (container == ContainerFormat::MP4 && VideoEncoder::isPipeOutput(config.outputPath) && !isGridPath(config.outputPath)) {
+            std::cerr << "Error: A plain mp4 can't be written to stdout or a pipe; use --container fmp4 or mpegts\n";
+            std::exit(1);
+        }
+
+        if (config.segments > 1 && container != ContainerFormat::MP4) {
+            std::cerr << "Error: --segments joins its parts into a plain mp4 file; it can't write fmp4, mpegts or stdout\n";
+            std::exit(1);
+        }
+
+        if (config.segments > 1 && streamInput) {
+            std::cerr << "Error: --segments needs a seekable input file, not a pipe or stream\n";
+            std::exit(1);
+        }
+
+        if (config.probeSize < 0 || config.analyzeDuration < 0 || config.readAheadMiB <= 0) {
+            std::cerr << "Error: --probesize and --analyzeduration must be 0 (default) or positive, --read-ahead positive\n";
+            std::exit(1);
+        }
+
+        if (config.segments > 1 && isGridPath(config.outputPath)) {
+            std::cerr << "Error: .agrid output can't be combined with --segments\n";
+            std::exit(1);
+        }
+
+        if (!config.fromGridPath.empty() && (config.segments > 1 || isGridPath(config.outputPath))) {
+            std::cerr << "Error: --from-grid can't be combined with --segments or .agrid output\n";
+            std::exit(1);
+        }
+
+        if (!config.terminalColour.empty()) {
+            TerminalColour colour;
+            if (!TerminalSink::parseColour(config.terminalColour, colour)) {
+                std::cerr << "Error: Invalid terminal colour mode '" << config.terminalColour << "'. Valid modes: truecolor 256 none\n";
+                std::exit(1);
+            }
+            if (!config.outputPath.empty() || config.segments > 1) {
+                std::cerr << "Error: --terminal can't be combined with an output file or --segments\n";
+                std::exit(1);
+            }
+        }
+
+        if (config.queueDepth <= 0) {
+            std::cerr << "Error: Queue depth must be positive\n";
+            std::exit(1);
+        }
+
         // Validate charset preset
         const std::unordered_map<std::string, std::string> validPresets = {
             {"standard", " .:-=+*#%@"},
@@ -205,16 +467,105 @@ AppConfig parseArguments(int argc, const char* argv[]) {
 
 void printConfig(const AppConfig& config) {
     std::cout << "Configuration:\n";
-    std::cout << "  Input: " << config.inputPath << "\n";
-    std::cout << "  Output: " << config.outputPath << "\n";
+    if (config.fromGridPath.empty()) {
+        std::cout << "  Input: " << config.inputPath
+                  << (ReadAheadIO::isStreamUrl(config.inputPath) ? " (stream, " + std::to_string(config.readAheadMiB) + " MiB read-ahead)" : "") << "\n";
+    } else {
+        std::cout << "  Input: " << config.fromGridPath << " (stored grids)\n";
+    }
+    if (config.terminalColour.empty()) {
+        std::cout << "  Output: " << config.outputPath << "\n";
+    } else {
+        std::cout << "  Output: terminal (" << config.terminalColour << " colours)\n";
+    }
     std::cout << "  Font: " << config.fontPath << "\n";
     std::cout << "  Charset: " << (config.customCharset.empty() ? config.charsetPreset : "custom") << "\n";
     std::cout << "  Block size: " << config.blockWidth << "x" << config.blockHeight << "\n";
+    std::cout << "  Convert mode: " << config.convertMode
+              << (config.convertMode == "scale" ? " (" + config.scaleFilter + ")" : "") << "\n";
+    std::cout << "  Render format: " << config.renderFormat << "\n";
     std::cout << "  Max frames: " << (config.maxFrames == -1 ? "all" : std::to_string(config.maxFrames)) << "\n";
+    if (config.startSeconds > 0.0 || config.endSeconds >= 0.0) {
+        std::cout << "  Time range: " << config.startSeconds << "s to ";
+        if (config.endSeconds >= 0.0) {
+            std::cout << config.endSeconds << "s\n";
+        } else {
+            std::cout << "end\n";
+        }
+    }
+    if (config.probeSize > 0 || config.analyzeDuration > 0) {
+        std::cout << "  Probe: " << (config.probeSize > 0 ? std::to_string(config.probeSize) + " bytes" : "default size")
+                  << ", " << (config.analyzeDuration > 0 ? std::to_string(config.analyzeDuration) + "us" : "default duration") << "\n";
+    }
     std::cout << "  Audio: " << (config.enableAudio ? "enabled" : "disabled") << "\n";
+    std::cout << "  Decode threads: " << (config.decodeThreads == 0 ? "auto" : std::to_string(config.decodeThreads))
+              << " (" << config.decodeThreadType << ")\n";
+    std::cout << "  Convert threads: " << (config.convertThreads == 0 ? "auto" : std::to_string(config.convertThreads)) << "\n";
+    std::cout << "  Render threads: " << (config.renderThreads == 0 ? "auto" : std::to_string(config.renderThreads)) << "\n";
+    if (config.motionSkip) {
+        std::cout << "  Motion skip: enabled\n";
+    }
+    if (config.dedupe) {
+        std::cout << "  Dedupe: enabled (variable frame rate)\n";
+    }
+    if (config.container != "auto") {
+        std::cout << "  Container: " << config.container << "\n";
+    }
+    std::cout << "  Encoder profile: " << config.encoderProfile
+              << (config.encoderThreads >= 0 ? ", " + std::to_string(config.encoderThreads) + " threads" : "") << "\n";
+    if (config.segments > 1) {
+        std::cout << "  Segments: " << config.segments
+                  << (config.segmentIndex >= 0 ? " (worker for segment " + std::to_string(config.segmentIndex) + ")" : "") << "\n";
+    }
+    std::cout << "  Pipeline: " << (config.pipeline ? "threaded, queue depth " + std::to_string(config.queueDepth) : "serial") << "\n";
+    if (!config.statsJsonPath.empty()) {
+        std::cout << "  Stats report: " << config.statsJsonPath << "\n";
+    }
+    if (!config.tracePath.empty()) {
+        std::cout << "  Trace: " << config.tracePath << "\n";
+    }
     std::cout << std::endl;
 }
 
+std::string segmentPath(const std::string& outputPath, int index) {
+    return outputPath + ".part" + std::to_string(index) + ".mp4";
+}
+
+bool isGridPath(const std::string& path) {
+    const std::string extension = ".agrid";
+    return path.size() > extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool parseTimestamp(const std::string& text, double& seconds) {
+    if (text.empty()) {
+        return false;
+    }
+    double total = 0.0;
+    size_t pos = 0;
+    int fields = 0;
+    while (true) {
+        const size_t colon = text.find(':', pos);
+        const std::string field = text.substr(pos, colon == std::string::npos ? std::string::npos : colon - pos);
+        const bool last = colon == std::string::npos;
+        // Only the seconds field may have a fraction
+        if (field.empty() || field.find_first_not_of(last ? "0123456789." : "0123456789") != std::string::npos ||
+            std::count(field.begin(), field.end(), '.') > 1 || field == ".") {
+            return false;
+        }
+        total = total * 60.0 + std::stod(field);
+        if (++fields > 3) {
+            return false;
+        }
+        if (last) {
+            break;
+        }
+        pos = colon + 1;
+    }
+    seconds = total;
+    return true;
+}
+
 const char* getAppErrorString(int errnum) {
     switch (static_cast<AppErrorCode>(errnum)) {
         case APP_ERR_SUCCESS: return "Success";
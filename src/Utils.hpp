@@ -67,10 +67,17 @@ private:
 struct AppConfig {
     std::string inputPath;
     std::string outputPath;
+    std::string terminalColour;     // Non-empty (truecolor, 256, none): play on the terminal instead of writing outputPath
+    std::string fromGridPath;       // Non-empty: render the grids stored in this .agrid file instead of decoding inputPath
     std::string fontPath = "./assets/RubikMonoOne-Regular.ttf";
     std::string charsetPreset = "detailed";
     std::string customCharset = "";
+    std::string convertMode = "rgb"; // rgb, yuv, scale
+    std::string scaleFilter = "area"; // swscale filter for the scale convert mode
+    std::string renderFormat = "yuv"; // rgb, yuv (yuv420p, what the encoder takes)
     int maxFrames = -1;  // -1 means process all frames
+    double startSeconds = 0.0;      // Seek here before processing
+    double endSeconds = -1.0;       // Stop here; negative means the end of the input
     int blockWidth = 8;
     int blockHeight = 12;
     bool enableAudio = true;
@@ -78,6 +85,25 @@ struct AppConfig {
     bool verbose = false;
     bool showProgress = true;
     double progressInterval = 5.0;  // Show progress every 5 seconds
+    int decodeThreads = 0;          // 0 = one per core
+    std::string decodeThreadType = "auto"; // auto (frame+slice), frame, slice
+    int convertThreads = 1;         // Threads converting bands of block rows; 0 = one per core, 1 = no band split
+    int renderThreads = 0;          // Threads drawing bands of grid rows; 0 = one per core, 1 = no band split
+    bool motionSkip = false;        // Reuse cells the decoder's motion vectors show as static
+    bool dedupe = false;            // Don't render/encode repeated grids; the output becomes variable frame rate
+    std::string encoderProfile = "balanced"; // throughput, balanced, archival
+    std::string container = "auto"; // auto, mp4, fmp4 (fragmented), mpegts
+    int encoderThreads = -1;        // -1 = the profile's, 0 = let x264 pick
+    int segments = 1;               // > 1: split at keyframes and encode each part in its own process
+    int segmentIndex = -1;          // >= 0: run as the worker for that segment only
+    bool concatOnly = false;        // Join already encoded segment files without spawning workers
+    bool pipeline = true;           // Run each stage on its own thread
+    int queueDepth = 4;             // Frames buffered between pipeline stages
+    int64_t probeSize = 0;          // Bytes read to detect the input format; 0 = FFmpeg's default
+    int64_t analyzeDuration = 0;    // Microseconds read to find stream parameters; 0 = FFmpeg's default
+    int readAheadMiB = 8;           // Read-ahead buffer for stdin, pipe and URL inputs
+    std::string statsJsonPath;      // Non-empty: time every stage and write a JSON report here at exit
+    std::string tracePath;          // Non-empty: write a Chrome trace_event timeline of every stage here at exit
 };
 
 namespace Utils {
@@ -86,6 +112,15 @@ namespace Utils {
 AppConfig parseArguments(int argc, const char *argv[]);
 void printConfig(const AppConfig &config);
 
+// Parses "SS[.frac]", "MM:SS[.frac]" or "HH:MM:SS[.frac]" into seconds; false if malformed or negative
+bool parseTimestamp(const std::string& text, double& seconds);
+
+// Where segment `index` of a --segments run is written: "<outputPath>.part<index>.mp4"
+std::string segmentPath(const std::string& outputPath, int index);
+
+// True for output paths ending in ".agrid", which get the converted grids instead of a rendered video
+bool isGridPath(const std::string& path);
+
 
 // Helper to get string description for AppErrorCode
 const char* getAppErrorString(int errnum);
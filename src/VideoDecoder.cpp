@@ -1,11 +1,18 @@
 #include "VideoDecoder.hpp"
+#include "ReadAheadIO.hpp"
+#include "Stats.hpp"
 #include "Utils.hpp" // AppErrorCode
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <thread>
 
 extern "C" {
     #include <libavutil/avutil.h>     // av_err2str, av_log_set_level
     #include <libavutil/error.h>      // AVERROR macro
     #include <libavutil/pixdesc.h>      // av_get_pix_fmt_name()
+    #include <libavutil/mathematics.h>  // av_rescale
 }
 
 namespace AsciiVideoFilter {
@@ -37,6 +44,13 @@ void VideoDecoder::cleanup() {
         avformat_close_input(&m_formatContext); // close file and free m_formatContext
         m_formatContext = nullptr;
     }
+    m_readAhead.reset(); // After the format context, which doesn't close a custom pb itself
+    m_audioStream = nullptr; // Freed with format context
+    m_audioStreamIndex = -1;
+    m_rangeStart = std::numeric_limits<int64_t>::min();
+    m_rangeEnd = std::numeric_limits<int64_t>::max();
+    m_rangeEndReached = false;
+    m_referenceFrames = 0;
 }
 
 int VideoDecoder::open(const std::string& filename) {
@@ -46,7 +60,35 @@ int VideoDecoder::open(const std::string& filename) {
     cleanup();
 
     // 1. Open input file
-    ret = avformat_open_input(&m_formatContext, filename.c_str(), nullptr, nullptr);
+    m_formatContext = avformat_alloc_context();
+    if (!m_formatContext) {
+        std::cerr << "Error (VideoDecoder::open): Could not allocate format context: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, AVERROR(ENOMEM)) << "\n";
+        return AVERROR(ENOMEM);
+    }
+    if (m_probeSize > 0) {
+        m_formatContext->probesize = m_probeSize;
+    }
+    if (m_analyzeDuration > 0) {
+        m_formatContext->max_analyze_duration = m_analyzeDuration;
+    }
+
+    // Streams are read ahead on their own thread so the source never waits on the decoder
+    std::string url = filename;
+    if (ReadAheadIO::isStreamUrl(filename)) {
+        m_readAhead = std::make_unique<ReadAheadIO>();
+        ret = m_readAhead->open(filename, m_readAheadBytes);
+        if (ret < 0) {
+            cleanup();
+            return ret;
+        }
+        m_formatContext->pb = m_readAhead->getContext();
+        m_formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+        if (filename == "-") {
+            url.clear(); // Nothing to guess the format from; probe the data
+        }
+    }
+
+    ret = avformat_open_input(&m_formatContext, url.c_str(), nullptr, nullptr);
     if (ret < 0) {
         std::cerr << "Error (VideoDecoder::open): Could not open input file '" << filename << "': " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
         cleanup();
@@ -94,6 +136,13 @@ int VideoDecoder::open(const std::string& filename) {
         return ret;
     }
 
+    // Without these avcodec decodes on a single thread, which heavy HEVC/AV1 sources can't keep up with
+    m_codecContext->thread_count = m_threadCount > 0 ? m_threadCount : static_cast<int>(std::thread::hardware_concurrency());
+    m_codecContext->thread_type = m_threadType;
+    if (m_exportMotionVectors) {
+        m_codecContext->flags2 |= AV_CODEC_FLAG2_EXPORT_MVS;
+    }
+
     ret = avcodec_open2(m_codecContext, codec, nullptr);
     if (ret < 0) {
         std::cerr << "Error (VideoDecoder::open): Could not open codec: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
@@ -113,10 +162,28 @@ int VideoDecoder::open(const std::string& filename) {
     std::cout << "VideoDecoder opened: " << filename
               << ", Resolution: " << m_codecContext->width << "x" << m_codecContext->height
               << ", Pixel Format: " << (pix_fmt_name ? pix_fmt_name : "unknown") << "\n";
+    LOG("Decoder threading: %d threads, %s\n", m_codecContext->thread_count,
+        m_codecContext->active_thread_type & FF_THREAD_FRAME ? "frame" :
+        m_codecContext->active_thread_type & FF_THREAD_SLICE ? "slice" : "none");
 
     // populate m_metadata
     populateMetadata();
 
+    switch (codec_params->codec_id) {
+    case AV_CODEC_ID_H264:
+        m_referenceFrames = std::max(0, parseH264ReferenceFrames(codec_params->extradata, codec_params->extradata_size));
+        break;
+    case AV_CODEC_ID_MPEG1VIDEO:
+    case AV_CODEC_ID_MPEG2VIDEO:
+    case AV_CODEC_ID_MPEG4:
+    case AV_CODEC_ID_H263:
+        m_referenceFrames = 1; // P frames predict from the previous I or P frame only
+        break;
+    default:
+        m_referenceFrames = 0;
+        break;
+    }
+
     // 6. Manually search for audio stream (remuxing audio stream in output)
     for (unsigned i = 0; i < m_formatContext->nb_streams; ++i) {
         AVStream* stream = m_formatContext->streams[i];
@@ -160,22 +227,267 @@ void VideoDecoder::populateMetadata() {
               << ", " << m_metadata.getTotalFrames() << " frames\n";
 }
 
-bool VideoDecoder::readNextAudioPacket(AVPacket* outPacket) {
-    if (!m_formatContext || m_audioStreamIndex == -1 || !outPacket) {
-        return false;
+// Reads the bits of an SPS with its emulation prevention bytes already removed
+namespace {
+struct BitReader {
+    const std::vector<uint8_t>& data;
+    size_t bit = 0;
+    bool overrun = false;
+
+    uint32_t bits(int count) {
+        uint32_t value = 0;
+        for (int i = 0; i < count; ++i) {
+            if (bit >= data.size() * 8) {
+                overrun = true;
+                return 0;
+            }
+            value = (value << 1) | ((data[bit / 8] >> (7 - bit % 8)) & 1);
+            bit++;
+        }
+        return value;
     }
 
-    while (av_read_frame(m_formatContext, outPacket) >= 0) {
-        if (outPacket->stream_index == m_audioStreamIndex) {
-            return true; // got an audio packet
+    // Exp-Golomb ue(v)
+    uint32_t ue() {
+        int zeros = 0;
+        while (!overrun && bits(1) == 0) {
+            if (++zeros > 31) {
+                overrun = true;
+                return 0;
+            }
         }
-        av_packet_unref(outPacket); // not audio, discard
+        return ((1u << zeros) - 1) + bits(zeros);
     }
 
-    return false; // end of file
+    int32_t se() {
+        const uint32_t code = ue();
+        return code & 1 ? static_cast<int32_t>((code + 1) / 2) : -static_cast<int32_t>(code / 2);
+    }
+};
+} // namespace
+
+int VideoDecoder::parseH264ReferenceFrames(const uint8_t* extradata, int size) {
+    if (!extradata || size < 4) {
+        return -1;
+    }
+
+    // Locate the first SPS NAL unit: avcC lists its SPSs after a 6-byte header, Annex B uses start codes
+    const uint8_t* nal = nullptr;
+    size_t nalSize = 0;
+    if (extradata[0] == 1) {
+        if (size >= 8 && (extradata[5] & 0x1F) > 0) {
+            nalSize = (extradata[6] << 8) | extradata[7];
+            nal = extradata + 8;
+            if (8 + nalSize > static_cast<size_t>(size)) {
+                return -1;
+            }
+        }
+    } else {
+        for (int i = 0; i + 3 < size; ++i) {
+            if (extradata[i] == 0 && extradata[i + 1] == 0 && extradata[i + 2] == 1 && (extradata[i + 3] & 0x1F) == 7) {
+                nal = extradata + i + 3;
+                int end = i + 3;
+                while (end + 2 < size && !(extradata[end] == 0 && extradata[end + 1] == 0 && extradata[end + 2] <= 1)) {
+                    end++;
+                }
+                nalSize = (end + 2 < size ? end : size) - (i + 3);
+                break;
+            }
+        }
+    }
+    if (!nal || nalSize < 2 || (nal[0] & 0x1F) != 7) {
+        return -1;
+    }
+
+    // RBSP after the NAL header, without emulation prevention bytes (00 00 03)
+    std::vector<uint8_t> rbsp;
+    rbsp.reserve(nalSize);
+    for (size_t i = 1; i < nalSize; ++i) {
+        if (i + 2 < nalSize && nal[i] == 0 && nal[i + 1] == 0 && nal[i + 2] == 3) {
+            rbsp.push_back(0);
+            rbsp.push_back(0);
+            i += 2;
+            continue;
+        }
+        rbsp.push_back(nal[i]);
+    }
+
+    BitReader reader{rbsp};
+    const uint32_t profile = reader.bits(8);
+    reader.bits(16);  // constraint flags, level_idc
+    reader.ue();      // seq_parameter_set_id
+    if (profile == 100 || profile == 110 || profile == 122 || profile == 244 || profile == 44 ||
+        profile == 83 || profile == 86 || profile == 118 || profile == 128 || profile == 138 ||
+        profile == 139 || profile == 134 || profile == 135) {
+        const uint32_t chromaFormat = reader.ue();
+        if (chromaFormat == 3) {
+            reader.bits(1);   // separate_colour_plane_flag
+        }
+        reader.ue();          // bit_depth_luma_minus8
+        reader.ue();          // bit_depth_chroma_minus8
+        reader.bits(1);       // qpprime_y_zero_transform_bypass_flag
+        if (reader.bits(1)) { // seq_scaling_matrix_present_flag
+            const int lists = chromaFormat == 3 ? 12 : 8;
+            for (int list = 0; list < lists && !reader.overrun; ++list) {
+                if (!reader.bits(1)) {
+                    continue;
+                }
+                const int entries = list < 6 ? 16 : 64;
+                int lastScale = 8;
+                int nextScale = 8;
+                for (int j = 0; j < entries && !reader.overrun; ++j) {
+                    if (nextScale != 0) {
+                        nextScale = (lastScale + reader.se() + 256) % 256;
+                    }
+                    lastScale = nextScale == 0 ? lastScale : nextScale;
+                }
+            }
+        }
+    }
+    reader.ue();              // log2_max_frame_num_minus4
+    const uint32_t pocType = reader.ue();
+    if (pocType == 0) {
+        reader.ue();          // log2_max_pic_order_cnt_lsb_minus4
+    } else if (pocType == 1) {
+        reader.bits(1);       // delta_pic_order_always_zero_flag
+        reader.se();          // offset_for_non_ref_pic
+        reader.se();          // offset_for_top_to_bottom_field
+        const uint32_t cycle = reader.ue();
+        for (uint32_t i = 0; i < cycle && !reader.overrun; ++i) {
+            reader.se();      // offset_for_ref_frame
+        }
+    }
+    const uint32_t referenceFrames = reader.ue();
+    return reader.overrun || referenceFrames > 16 ? -1 : static_cast<int>(referenceFrames);
+}
+
+size_t VideoDecoder::getReadAheadPeak() const {
+    return m_readAhead ? m_readAhead->getPeakFill() : 0;
+}
+
+size_t VideoDecoder::getReadAheadCapacity() const {
+    return m_readAhead ? m_readAhead->getCapacity() : 0;
 }
 
 bool VideoDecoder::readFrame(AVFrame* out_frame) {
+    if (m_rangeEndReached) {
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    bool gotFrame = false;
+    while ((gotFrame = decodeNextFrame(out_frame))) {
+        const int64_t pts = out_frame->best_effort_timestamp;
+        if (pts != AV_NOPTS_VALUE && pts < m_rangeStart) {
+            // Decoded only to reach the range start (or an open-GOP leading picture of the previous range)
+            av_frame_unref(out_frame);
+            continue;
+        }
+        if (pts != AV_NOPTS_VALUE && pts >= m_rangeEnd) {
+            av_frame_unref(out_frame);
+            m_rangeEndReached = true;
+            gotFrame = false;
+        }
+        break;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    m_decodeSeconds += std::chrono::duration<double>(end - start).count();
+    if (gotFrame) {
+        Stats::recordSpan(Stage::Decode, start, end);
+    }
+    return gotFrame;
+}
+
+int VideoDecoder::seekVideo(int64_t pts) {
+    int ret = av_seek_frame(m_formatContext, m_videoStreamIndex, pts, AVSEEK_FLAG_BACKWARD);
+    if (ret < 0) {
+        std::cerr << "Error (VideoDecoder::seekVideo): Seek failed: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        return ret;
+    }
+    avcodec_flush_buffers(m_codecContext);
+    return 0;
+}
+
+int VideoDecoder::findSegmentBoundaries(int count, std::vector<int64_t>& boundaries) {
+    if (!m_formatContext || !m_codecContext || !m_packet || count <= 0) {
+        std::cerr << "Error (VideoDecoder::findSegmentBoundaries): Decoder not properly initialized.\n";
+        return static_cast<int>(AppErrorCode::APP_ERR_DECODER_NOT_FOUND);
+    }
+    if (!isSeekable()) {
+        std::cerr << "Error (VideoDecoder::findSegmentBoundaries): Input can't be seeked, so it can't be split.\n";
+        return AVERROR(ESPIPE);
+    }
+
+    AVStream* stream = m_formatContext->streams[m_videoStreamIndex];
+    const int64_t streamStart = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    int64_t duration = stream->duration;
+    if (duration <= 0 && m_formatContext->duration > 0) {
+        duration = av_rescale_q(m_formatContext->duration, AV_TIME_BASE_Q, stream->time_base);
+    }
+
+    boundaries.assign(count + 1, std::numeric_limits<int64_t>::min());
+    boundaries[count] = std::numeric_limits<int64_t>::max();
+
+    // Each inner boundary is the first keyframe at or before an evenly spaced target
+    for (int i = 1; i < count; ++i) {
+        int64_t boundary = boundaries[i - 1];
+        if (duration > 0 && seekVideo(streamStart + av_rescale(duration, i, count)) >= 0) {
+            while (av_read_frame(m_formatContext, m_packet) >= 0) {
+                const bool isKeyframe = m_packet->stream_index == m_videoStreamIndex &&
+                                        (m_packet->flags & AV_PKT_FLAG_KEY) && m_packet->pts != AV_NOPTS_VALUE;
+                const int64_t pts = m_packet->pts;
+                av_packet_unref(m_packet);
+                if (isKeyframe) {
+                    boundary = pts;
+                    break;
+                }
+            }
+        }
+        // Two targets landing on the same keyframe leave an empty segment between them
+        boundaries[i] = std::max(boundary, boundaries[i - 1]);
+    }
+
+    return seekVideo(streamStart);
+}
+
+int VideoDecoder::setPtsRange(int64_t start, int64_t end) {
+    if (!m_formatContext || !m_codecContext) {
+        std::cerr << "Error (VideoDecoder::setPtsRange): Decoder not properly initialized.\n";
+        return static_cast<int>(AppErrorCode::APP_ERR_DECODER_NOT_FOUND);
+    }
+
+    m_rangeStart = start;
+    m_rangeEnd = end;
+    m_rangeEndReached = false;
+    if (start == std::numeric_limits<int64_t>::min()) {
+        return 0;
+    }
+    if (!isSeekable()) {
+        // readFrame() drops everything before start; slower, but all a stream allows
+        return 0;
+    }
+    return seekVideo(start);
+}
+
+int VideoDecoder::setTimeRange(double startSeconds, double endSeconds) {
+    if (!m_formatContext || !m_codecContext) {
+        std::cerr << "Error (VideoDecoder::setTimeRange): Decoder not properly initialized.\n";
+        return static_cast<int>(AppErrorCode::APP_ERR_DECODER_NOT_FOUND);
+    }
+
+    AVStream* stream = m_formatContext->streams[m_videoStreamIndex];
+    const int64_t streamStart = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    auto toPts = [&](double seconds) {
+        return streamStart + av_rescale_q(std::llround(seconds * AV_TIME_BASE), AV_TIME_BASE_Q, stream->time_base);
+    };
+
+    // Starting at zero needs no seek; keep the range open so frames with pts below start_time still count
+    const int64_t start = startSeconds > 0.0 ? toPts(startSeconds) : std::numeric_limits<int64_t>::min();
+    const int64_t end = endSeconds >= 0.0 ? toPts(endSeconds) : std::numeric_limits<int64_t>::max();
+    return setPtsRange(start, end);
+}
+
+bool VideoDecoder::decodeNextFrame(AVFrame* out_frame) {
     if (!m_formatContext || !m_codecContext || !m_packet || !out_frame) {
         std::cerr << "Error (VideoDecoder::readFrame): Decoder not properly initialized.\n";
         return false; // Indicate failure
@@ -240,6 +552,12 @@ bool VideoDecoder::readFrame(AVFrame* out_frame) {
                     av_packet_unref(m_packet); // Ensure packet is unreferenced even on error
                     return false; // Error, cannot proceed
                 }
+            } else if (m_packet->stream_index == m_audioStreamIndex && m_audioPacketHandler) {
+                // Audio is routed out in the same pass so the input never has to be read twice
+                if (m_audioPacketHandler(m_packet) < 0) {
+                    std::cerr << "Error (VideoDecoder::readFrame): Audio packet handler failed. Dropping remaining audio.\n";
+                    m_audioPacketHandler = nullptr;
+                }
             }
             av_packet_unref(m_packet); // Packet data is consumed, unreference it
         } else {
@@ -2,7 +2,12 @@
 
 #include "Utils.hpp"
 
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 extern "C" {
     #include <libavcodec/codec.h>
@@ -15,6 +20,8 @@ extern "C" {
 
 namespace AsciiVideoFilter {
 
+class ReadAheadIO;
+
 class VideoDecoder {
 public:
     /**
@@ -29,24 +36,101 @@ public:
 
     /**
      *  Opens the input video file and prepares streams for decoding.
-     *  @param filename The path to the video file
+     *
+     *  "-" (stdin), named pipes and network URLs (udp://, tcp://, ...) are read through a ReadAheadIO
+     *  and can't be seeked: --start is then reached by decoding and dropping frames.
+     *  @param filename The path to the video file, "-" or an FFmpeg URL
      *  @return 0 (APP_ERR_SUCCESS) on success, or a negative FFmpeg or AppErrorCode on failure.
      */
     int open(const std::string& filename);
 
+    /**
+     * @brief Sets how the video decoder is threaded. Takes effect on the next open().
+     *
+     * @param threadCount Decoder threads; 0 sizes it to the number of cores.
+     * @param threadType FF_THREAD_FRAME, FF_THREAD_SLICE or both. FFmpeg uses whichever of these
+     *                   the codec supports (frame threading when it can).
+     */
+    void setThreading(int threadCount, int threadType) {
+        m_threadCount = threadCount;
+        m_threadType = threadType;
+    }
+
+    /**
+     * @brief Sets how much of the input is probed and how far streamed inputs are read ahead. Takes
+     * effect on the next open().
+     *
+     * @param probeSize Bytes avformat may read to detect the format; 0 keeps FFmpeg's default.
+     * @param analyzeDuration Microseconds of input avformat may read to find stream parameters; 0
+     *                        keeps FFmpeg's default. Lower both to start a live stream sooner.
+     * @param readAheadBytes Capacity of the read-ahead buffer for stdin, pipes and URLs.
+     */
+    void setStreamOptions(int64_t probeSize, int64_t analyzeDuration, size_t readAheadBytes) {
+        m_probeSize = probeSize;
+        m_analyzeDuration = analyzeDuration;
+        m_readAheadBytes = readAheadBytes;
+    }
+
+    /**
+     * @brief Asks the decoder to attach motion vectors (AV_FRAME_DATA_MOTION_VECTORS) to each
+     * inter-coded frame. Takes effect on the next open(); codecs without support simply attach none.
+     */
+    void setExportMotionVectors(bool enable) { m_exportMotionVectors = enable; }
+
     /**
      * Reads and decodes a single video frame.
+     * Audio packets met along the way are passed to the audio packet handler, if one is set.
      * @param *out_frame will contain the decoded raw video data.
      * @return true if a frame was successfully decoded, false if end of stream or no frame yet.
      */
     bool readFrame(AVFrame* out_frame);
 
     /**
-     * @brief Reads the next packet from the input audio stream.
-     * @param outPacket Packet to be filled with raw (compressed) audio data.
-     * @return true if a packet was read successfully, false if end of stream or failure.
+     * @brief Splits the video stream at keyframes into count segments of roughly equal duration.
+     *
+     * Call after open() and before reading frames; leaves the input positioned at its start.
+     * The result is deterministic for a given file and count, so independent workers (even on other
+     * machines) agree on the split without talking to each other.
+     *
+     * @param count Number of segments wanted.
+     * @param boundaries Receives count + 1 video-stream pts values; segment i is
+     *                   [boundaries[i], boundaries[i + 1]). The first is INT64_MIN and the last
+     *                   INT64_MAX. Inner ones are keyframe pts; a segment is empty (equal bounds) when
+     *                   the stream has too few keyframes to split that finely.
+     * @return 0 on success, or a negative FFmpeg/AppErrorCode on failure.
+     */
+    int findSegmentBoundaries(int count, std::vector<int64_t>& boundaries);
+
+    /**
+     * @brief Restricts readFrame() to frames with start <= pts < end (video stream time base).
+     *
+     * Seeks to the keyframe at or before start; frames before start are decoded and dropped, and
+     * readFrame() reports end of stream at the first frame at or past end.
+     * @return 0 on success, or a negative FFmpeg error code if the seek fails.
+     */
+    int setPtsRange(int64_t start, int64_t end);
+
+    /**
+     * @brief setPtsRange() in seconds from the start of the video stream.
+     * @param startSeconds First time to return a frame for.
+     * @param endSeconds Time to stop at, or negative to read to the end of the stream.
+     * @return 0 on success, or a negative FFmpeg error code if the seek fails.
+     */
+    int setTimeRange(double startSeconds, double endSeconds);
+
+    /// Current range bounds (video stream time base); INT64_MIN / INT64_MAX when unrestricted
+    int64_t getRangeStart() const { return m_rangeStart; }
+    int64_t getRangeEnd() const { return m_rangeEnd; }
+
+    /**
+     * @brief Routes audio packets to a consumer while video is being demuxed.
+     *
+     * The handler is called from readFrame() with each packet of the audio stream, timestamps still
+     * in the input audio stream's time base. It must not keep the packet. If it returns a negative
+     * value the handler is dropped and the remaining audio packets are discarded.
+     * @param handler Callback receiving the packet, or an empty function to discard audio.
      */
-    bool readNextAudioPacket(AVPacket* outPacket);
+    void setAudioPacketHandler(std::function<int(AVPacket*)> handler) { m_audioPacketHandler = std::move(handler); }
 
     // Getters for video stream properties. Returns 0 or AV_PIX_FMT_NONE if context is not open.
     int getWidth() const { return m_codecContext ? m_codecContext->width : 0; }
@@ -58,6 +142,40 @@ public:
 
     bool hasAudio() const { return m_audioStreamIndex != -1; }
 
+    // False for stdin, pipes and most network streams; seeking (--start, segments) needs a seekable input
+    bool isSeekable() const { return m_formatContext && m_formatContext->pb && (m_formatContext->pb->seekable & AVIO_SEEKABLE_NORMAL); }
+
+    // Fullest the read-ahead buffer has been and its capacity, both 0 for inputs read directly
+    size_t getReadAheadPeak() const;
+    size_t getReadAheadCapacity() const;
+
+    // Threading the opened decoder actually uses (FFmpeg may reduce what was asked for)
+    int getThreadCount() const { return m_codecContext ? m_codecContext->thread_count : 0; }
+    int getActiveThreadType() const { return m_codecContext ? m_codecContext->active_thread_type : 0; }
+
+    // Frames the decoder holds back to put them in display order (AVCodecContext::has_b_frames), 0 without B-frames
+    int getReorderDelay() const { return m_codecContext ? m_codecContext->has_b_frames : 0; }
+
+    /**
+     * @brief Most reference frames a P frame of the video stream may predict from: max_num_ref_frames
+     *        of the H.264 SPS, 1 for MPEG-1/2/4 and H.263, 0 when unknown.
+     *
+     * Read from the stream's extradata at open(). AVCodecContext::refs can't be used here: it is only
+     * set once a slice has been decoded, and not at all on the user's context with frame threading.
+     */
+    int getReferenceFrames() const { return m_referenceFrames; }
+
+    /**
+     * @brief max_num_ref_frames of the first SPS in H.264 extradata (avcC or Annex B).
+     * @return The count, or -1 if there is no SPS or it can't be parsed.
+     */
+    static int parseH264ReferenceFrames(const uint8_t* extradata, int size);
+
+    /**
+     * @brief Wall time spent inside readFrame() so far (demuxing, decoding and the audio handler).
+     */
+    double getDecodeSeconds() const { return m_decodeSeconds; }
+
 
     /**
      * @brief Gets comprehensive video metadata for encoding.
@@ -78,12 +196,34 @@ private:
     // audio stream for remuxing into the output
     AVStream *m_audioStream = nullptr;
     int m_audioStreamIndex = -1;
+    std::function<int(AVPacket*)> m_audioPacketHandler; ///< Receives audio packets during readFrame()
+
+    int m_threadCount = 0;                                ///< 0 = one per core
+    int m_threadType = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    bool m_exportMotionVectors = false;                   ///< Sets AV_CODEC_FLAG2_EXPORT_MVS on open()
+    int m_referenceFrames = 0;                            ///< See getReferenceFrames()
+    double m_decodeSeconds = 0.0;                         ///< Accumulated by readFrame()
+
+    // Streamed inputs
+    int64_t m_probeSize = 0;                              ///< 0 = FFmpeg's default
+    int64_t m_analyzeDuration = 0;                        ///< Microseconds; 0 = FFmpeg's default
+    size_t m_readAheadBytes = 8 << 20;
+    std::unique_ptr<ReadAheadIO> m_readAhead;             ///< Set while a streamed input is open
+
+    // Frames outside [m_rangeStart, m_rangeEnd) are dropped by readFrame()
+    int64_t m_rangeStart = std::numeric_limits<int64_t>::min();
+    int64_t m_rangeEnd = std::numeric_limits<int64_t>::max();
+    bool m_rangeEndReached = false;
 
     // Private helpers
     // cleans up resources (called by destructor and on error in open())
     void cleanup();
     // populates m_metadata (called by open())
     void populateMetadata();
+    // the body of readFrame(), which adds the time it takes to m_decodeSeconds and applies the pts range
+    bool decodeNextFrame(AVFrame* out_frame);
+    // seeks the video stream to the keyframe at or before pts and resets the decoder
+    int seekVideo(int64_t pts);
 
     VideoDecoder(const VideoDecoder&) = delete; // Disable copy constructor
     VideoDecoder& operator=(const VideoDecoder&) = delete; // Disable operator= overload
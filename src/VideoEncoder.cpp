@@ -1,6 +1,8 @@
 #include "VideoEncoder.hpp"
+#include "Stats.hpp"
 #include <iostream>
 #include <cstring>
+#include <sys/stat.h>
 #include <libavutil/rational.h>
 
 extern "C" {
@@ -63,12 +65,42 @@ void VideoEncoder::cleanup() {
     }
 
     m_videoStream = nullptr; // Freed with format context
+    m_outputAudioStream = nullptr;
+    m_hasAudio = false;
+    m_headerWritten = false;
     m_frameCount = 0;
+    m_nextPts = 0;
 
 }
 
+namespace EncoderProfiles {
+
+const std::vector<EncoderProfile>& all() {
+    // ASCII frames are flat colour on black with hard glyph edges, hence tune stillimage throughout
+    static const std::vector<EncoderProfile> profiles = {
+        // Fastest encode: cheap preset, no B-frames, short lookahead, long GOP
+        {"throughput", "veryfast", "stillimage", 28, 250, 0, 10, 0},
+        // The original hardcoded settings
+        {"balanced", "medium", "stillimage", 28, 12, 1, -1, 0},
+        // Smallest file at higher quality, slow
+        {"archival", "slow", "stillimage", 20, 250, 3, 60, 0},
+    };
+    return profiles;
+}
+
+const EncoderProfile* find(const std::string& name) {
+    for (const auto& profile : all()) {
+        if (name == profile.name) {
+            return &profile;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace EncoderProfiles
+
 int VideoEncoder::init(const std::string& outputPath, const VideoMetadata& metadata,
-                       int width, int height, int64_t bitrate) {
+                       int width, int height, const EncoderProfile& profile) {
     cleanup();
 
     m_width = width;
@@ -78,7 +110,10 @@ int VideoEncoder::init(const std::string& outputPath, const VideoMetadata& metad
     int ret;
 
     // 1. Allocate output format context
-    ret = avformat_alloc_output_context2(&m_formatContext, nullptr, "mp4", outputPath.c_str());
+    const bool streaming = m_container != ContainerFormat::MP4;
+    const std::string url = outputPath == "-" ? "pipe:1" : outputPath;
+    ret = avformat_alloc_output_context2(&m_formatContext, nullptr,
+                                         m_container == ContainerFormat::MPEGTS ? "mpegts" : "mp4", url.c_str());
     if (ret < 0 || !m_formatContext) {
         std::cerr << "Error (VideoEncoder::init): Could not create output context: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
         cleanup();
@@ -112,20 +147,25 @@ int VideoEncoder::init(const std::string& outputPath, const VideoMetadata& metad
 
     // 5. Configure codec parameters
     m_codecContext->codec_id = AV_CODEC_ID_H264;
-    m_codecContext->bit_rate = bitrate;
     m_codecContext->width = m_width;
     m_codecContext->height = m_height;
     m_codecContext->time_base = av_inv_q(metadata.frameRate);
     LOG("DEBUG: VideoEncoder codecContext time_base set to: %d/%d\n", m_codecContext->time_base.num, m_codecContext->time_base.den);
     m_codecContext->framerate = av_inv_q(metadata.timeBase); // fps = 1/timebase
     m_codecContext->pix_fmt = AV_PIX_FMT_YUV420P; // H.264 standard format
-    m_codecContext->gop_size = 12; // Keyframe interval
-    m_codecContext->max_b_frames = 1;
+    m_codecContext->gop_size = profile.gopSize; // Keyframe interval
+    m_codecContext->max_b_frames = profile.maxBFrames;
+    m_codecContext->thread_count = profile.threads;
 
-    // Set H.264 preset for good compression/speed balance
-    av_opt_set(m_codecContext->priv_data, "preset", "medium", 0);
-    av_opt_set(m_codecContext->priv_data, "crf", "28", 0); // Constant Rate Factor
-    av_opt_set(m_codecContext->priv_data, "tune", "stillimage", 0);
+    // x264 settings from the encoder profile
+    av_opt_set(m_codecContext->priv_data, "preset", profile.preset, 0);
+    av_opt_set_int(m_codecContext->priv_data, "crf", profile.crf, 0); // Constant Rate Factor
+    if (profile.tune) {
+        av_opt_set(m_codecContext->priv_data, "tune", profile.tune, 0);
+    }
+    if (profile.lookahead >= 0) {
+        av_opt_set_int(m_codecContext->priv_data, "rc-lookahead", profile.lookahead, 0);
+    }
     
     // Some formats want stream headers to be separate
     if (m_formatContext->oformat->flags & AVFMT_GLOBALHEADER) {
@@ -149,21 +189,21 @@ int VideoEncoder::init(const std::string& outputPath, const VideoMetadata& metad
     }
     
     // 8. Open output file
-    ret = avio_open(&m_formatContext->pb, outputPath.c_str(), AVIO_FLAG_WRITE);
+    ret = avio_open(&m_formatContext->pb, url.c_str(), AVIO_FLAG_WRITE);
     if (ret < 0) {
         std::cerr << "Error (VideoEncoder::init): Could not open output file '" << outputPath << "': " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
         cleanup();
         return ret;
     }
     
-    // 9. Write file header
-    ret = avformat_write_header(m_formatContext, nullptr);
-    if (ret < 0) {
-        std::cerr << "Error (VideoEncoder::init): Error writing header: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
-        cleanup();
-        return ret;
+    // 9. The file header is written with the first packet (see ensureHeader()),
+    //    which leaves room for addAudioStreamFrom() after init.
+    //    Streamed containers hand every packet to the pipe (or disk) as soon as it's muxed, so the
+    //    next process sees frames promptly and a crash loses only what was still in the encoder.
+    if (streaming) {
+        m_formatContext->flush_packets = 1;
     }
-    
+
     // 10. Set up color space conversion (RGB24 -> YUV420P)
     m_swsContext = sws_getContext(m_width, m_height, AV_PIX_FMT_RGB24,
                                   m_width, m_height, AV_PIX_FMT_YUV420P,
@@ -210,9 +250,11 @@ int VideoEncoder::init(const std::string& outputPath, const VideoMetadata& metad
         return AVERROR(ENOMEM);
     }
     
-    std::cout << "VideoEncoder initialized: " << outputPath 
+    static const char* const containerNames[] = {"mp4", "fragmented mp4", "mpegts"};
+    std::cout << "VideoEncoder initialized: " << outputPath
+              << " (" << containerNames[static_cast<int>(m_container)] << ")"
               << ", " << m_width << "x" << m_height 
-              << ", " << bitrate/1000 << "kbps"
+              << ", profile " << profile.name << " (" << profile.preset << ", crf " << profile.crf << ")"
               << ", " << av_q2d(av_inv_q(m_timeBase)) << "fps\n";
     
     return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
@@ -242,6 +284,8 @@ int VideoEncoder::addAudioStreamFrom(AVStream* inAudioStream) {
 
     // Set the codec tag if it's not set (important for some formats)
     m_outputAudioStream->codecpar->codec_tag = 0;
+    m_outputAudioStream->time_base = inAudioStream->time_base; // Muxer may still adjust this in the header
+    m_inputAudioTimeBase = inAudioStream->time_base;
 
     m_hasAudio = true;
 
@@ -257,24 +301,19 @@ int VideoEncoder::writeAudioPacket(AVPacket *packet) {
         return -1;
     }
 
-    // Crucial: Rescale PTS and DTS from the *input* audio stream's timebase
-    // to the *output* audio stream's timebase.
-    // The input packet's time_base is implicitly packet->time_base (which FFmpeg often sets to the stream's time_base)
-    // The source time_base for the packet is *the input audio stream's time base*.
-    // You need to get this from the decoder.
-    // For now, let's assume `packet->time_base` is correct if it came from `readNextAudioPacket`.
-
-    // NOTE: This assumes the input `packet->time_base` is correctly set by FFmpeg based on its source stream.
-    // If not, you'd need `av_packet_rescale_ts(packet, inAudioStream->time_base, m_outputAudioStream->time_base);`
-    // where `inAudioStream->time_base` is the timebase of the *original* audio stream from the decoder.
-    // Since `readNextAudioPacket` just reads raw packets, `packet->time_base` should be populated correctly.
-    av_packet_rescale_ts(packet, packet->time_base, m_outputAudioStream->time_base);
-
+    std::lock_guard<std::mutex> lock(m_muxMutex);
+    int ret = ensureHeader();
+    if (ret < 0) {
+        return ret;
+    }
 
+    // Packets come straight from the demuxer, so their timestamps are in the input stream's time base
+    av_packet_rescale_ts(packet, m_inputAudioTimeBase, m_outputAudioStream->time_base);
     packet->stream_index = m_outputAudioStreamIndex; // Set to the *output* audio stream index
 
     // Write the packet to the output file
-    int ret = av_interleaved_write_frame(m_formatContext, packet);
+    Stats::ScopedTimer timer(Stage::Mux);
+    ret = av_interleaved_write_frame(m_formatContext, packet);
     if (ret < 0) {
         std::cerr << "Error (VideoEncoder::writeAudioPacket): Failed to write audio packet: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
         return ret;
@@ -282,21 +321,32 @@ int VideoEncoder::writeAudioPacket(AVPacket *packet) {
     return 0;
 }
 
-int VideoEncoder::encodeFrame(AVFrame* frame) {
+int VideoEncoder::encodeFrame(AVFrame* frame, int64_t frameIndex) {
     if (!m_codecContext || !m_yuvFrame || !frame) {
         std::cerr << "Error (VideoEncoder::encodeFrame): Encoder not initialized.\n";
         return static_cast<int>(AppErrorCode::APP_ERR_CONVERTER_INIT_FAILED);
     }
+    Stats::ScopedTimer timer(Stage::Encode);
     
-    // Convert RGB24 to YUV420P
-    sws_scale(m_swsContext, frame->data, frame->linesize, 0, frame->height,
-              m_yuvFrame->data, m_yuvFrame->linesize);
+    // Frames already in the encoder's format (AsciiRenderer's yuv420p output) go straight in;
+    // anything else is RGB24 and gets converted
+    AVFrame* encoderFrame = m_yuvFrame;
+    if (frame->format == m_codecContext->pix_fmt && frame->width == m_width && frame->height == m_height) {
+        encoderFrame = frame;
+    } else {
+        Stats::ScopedTimer colourTimer(Stage::EncodeColour);
+        sws_scale(m_swsContext, frame->data, frame->linesize, 0, frame->height,
+                  m_yuvFrame->data, m_yuvFrame->linesize);
+    }
     
-    // Set frame timing
-    m_yuvFrame->pts = m_frameCount++;
+    // Set frame timing. The time base is one source frame, so a gap in the indices simply keeps
+    // the previous frame on screen for longer.
+    encoderFrame->pts = frameIndex >= 0 ? frameIndex : m_nextPts;
+    m_nextPts = encoderFrame->pts + 1;
+    m_frameCount++;
     
     // Send frame to encoder
-    int ret = avcodec_send_frame(m_codecContext, m_yuvFrame);
+    int ret = avcodec_send_frame(m_codecContext, encoderFrame);
     if (ret < 0) {
         std::cerr << "Error (VideoEncoder::encodeFrame): Error sending frame to encoder: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
         return ret;
@@ -362,6 +412,11 @@ int VideoEncoder::finalize() {
     }
 
     // Write file trailer
+    std::lock_guard<std::mutex> lock(m_muxMutex);
+    ret = ensureHeader(); // nothing was encoded, still produce a valid file
+    if (ret < 0) {
+        return ret;
+    }
     ret = av_write_trailer(m_formatContext);
     if (ret < 0) {
         std::cerr << "Error (VideoEncoder::finalize): Error writing trailer: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
@@ -372,13 +427,67 @@ int VideoEncoder::finalize() {
     return static_cast<int>(AppErrorCode::APP_ERR_SUCCESS);
 }
 
+bool VideoEncoder::parseContainer(const std::string& name, const std::string& outputPath, ContainerFormat& container) {
+    if (name == "mp4") {
+        container = ContainerFormat::MP4;
+    } else if (name == "fmp4") {
+        container = ContainerFormat::FRAGMENTED_MP4;
+    } else if (name == "mpegts") {
+        container = ContainerFormat::MPEGTS;
+    } else if (name == "auto") {
+        auto endsWith = [&outputPath](const std::string& extension) {
+            return outputPath.size() > extension.size() &&
+                   outputPath.compare(outputPath.size() - extension.size(), extension.size(), extension) == 0;
+        };
+        container = endsWith(".ts") || endsWith(".m2ts") ? ContainerFormat::MPEGTS :
+                    isPipeOutput(outputPath) ? ContainerFormat::FRAGMENTED_MP4 : ContainerFormat::MP4;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool VideoEncoder::isPipeOutput(const std::string& outputPath) {
+    struct stat info;
+    return outputPath == "-" || outputPath.compare(0, 5, "pipe:") == 0 ||
+           (stat(outputPath.c_str(), &info) == 0 && S_ISFIFO(info.st_mode));
+}
+
+int VideoEncoder::ensureHeader() {
+    if (m_headerWritten) {
+        return 0;
+    }
+
+    // A plain MP4 needs a seekable output to put the moov in place at the end; a fragmented one
+    // writes an empty moov now and a moof+mdat per keyframe, each playable as soon as it's written
+    AVDictionary* options = nullptr;
+    if (m_container == ContainerFormat::FRAGMENTED_MP4) {
+        av_dict_set(&options, "movflags", "empty_moov+frag_keyframe+default_base_moof", 0);
+    }
+    int ret = avformat_write_header(m_formatContext, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        std::cerr << "Error (VideoEncoder::ensureHeader): Error writing header: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
+        return ret;
+    }
+    m_headerWritten = true;
+    return 0;
+}
+
 int VideoEncoder::writePacket(AVPacket* packet) {
+    std::lock_guard<std::mutex> lock(m_muxMutex);
+    int ret = ensureHeader();
+    if (ret < 0) {
+        return ret;
+    }
+
     // Rescale packet timestamps to stream timebase
     av_packet_rescale_ts(packet, m_codecContext->time_base, m_videoStream->time_base);
     packet->stream_index = m_videoStream->index;
     
     // Write packet to output file
-    int ret = av_interleaved_write_frame(m_formatContext, packet);
+    Stats::ScopedTimer timer(Stage::Mux);
+    ret = av_interleaved_write_frame(m_formatContext, packet);
     if (ret < 0) {
         std::cerr << "Error (VideoEncoder::writePacket): Error writing packet: " << av_make_error_string(m_errbuf, AV_ERROR_MAX_STRING_SIZE, ret) << "\n";
         return ret;
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <mutex>
 #include <string>
+#include <vector>
 #include "Utils.hpp"
 
 extern "C" {
@@ -14,12 +16,51 @@ extern "C" {
 
 namespace AsciiVideoFilter {
 
+/**
+ * @brief Named bundle of x264 settings that trade encode speed against size and quality.
+ */
+struct EncoderProfile {
+    const char* name;
+    const char* preset;   ///< x264 preset
+    const char* tune;     ///< x264 tune, or nullptr for none
+    int crf;              ///< Constant Rate Factor (rate control is always CRF)
+    int gopSize;          ///< Keyframe interval in frames
+    int maxBFrames;
+    int lookahead;        ///< x264 rc-lookahead in frames, -1 to keep the preset's
+    int threads;          ///< Encoder threads, 0 = let x264 pick (about 1.5x the core count)
+};
+
+namespace EncoderProfiles {
+
+/**
+ * @brief Every built-in profile: throughput, balanced (the default), archival.
+ */
+const std::vector<EncoderProfile>& all();
+
+/**
+ * @brief Looks a profile up by name.
+ * @return The profile, or nullptr if there is none with that name.
+ */
+const EncoderProfile* find(const std::string& name);
+
+} // namespace EncoderProfiles
+
+/**
+ * @brief Container the encoded stream is muxed into.
+ */
+enum class ContainerFormat {
+    MP4,            ///< Plain MP4: the index (moov) is written last, so the file is unplayable until finalize()
+    FRAGMENTED_MP4, ///< Empty moov up front, then a self-contained fragment per keyframe; pipeable
+    MPEGTS          ///< MPEG transport stream; pipeable, and SPS/PPS repeat at every keyframe
+};
+
 /**
  * @class VideoEncoder
  * @brief Encodes RGB frames to MP4 video format using H.264 codec.
  *
- * Takes RGB24 frames (typically from AsciiRenderer) and encodes them into
- * an MP4 container with H.264 compression, preserving original video timing.
+ * Takes RGB24 or YUV420P frames (typically from AsciiRenderer) and encodes them into
+ * an MP4 container with H.264 compression, preserving original video timing. Fragmented MP4 and
+ * MPEG-TS can be written to "-" (stdout) or a pipe while encoding is still running.
  */
 class VideoEncoder {
 public:
@@ -33,18 +74,36 @@ public:
      */
     ~VideoEncoder();
 
+    /**
+     * @brief Selects the container. Takes effect on the next init().
+     */
+    void setContainer(ContainerFormat container) { m_container = container; }
+
+    /**
+     * @brief Parses "mp4", "fmp4", "mpegts" or "auto". Auto picks MPEG-TS for .ts/.m2ts paths,
+     *        fragmented MP4 for "-" and named pipes, and MP4 otherwise.
+     * @return false for an unknown name.
+     */
+    static bool parseContainer(const std::string& name, const std::string& outputPath, ContainerFormat& container);
+
+    /**
+     * @brief True for outputs that can't be seeked: "-" (stdout), "pipe:" URLs and named pipes.
+     *        A plain MP4 can't be written to these.
+     */
+    static bool isPipeOutput(const std::string& outputPath);
+
     /**
      * @brief Initializes the encoder with output file and video parameters.
      *
-     * @param outputPath Path to output MP4 file.
+     * @param outputPath Path to output file, or "-" for stdout.
      * @param metadata Video metadata from the source (fps, duration, etc.).
      * @param width Output video width in pixels.
      * @param height Output video height in pixels.
-     * @param bitrate Target bitrate in bits per second (default: 2Mbps).
+     * @param profile x264 settings: preset, rate control, GOP, B-frames, lookahead and threads.
      * @return 0 on success, or negative FFmpeg/AppErrorCode on failure.
      */
     int init(const std::string& outputPath, const VideoMetadata& metadata,
-             int width, int height, int64_t bitrate = 2000000);
+             int width, int height, const EncoderProfile& profile);
 
     /**
      * @brief Adds an audio stream to the output file by copying parameters from the input stream.
@@ -57,18 +116,26 @@ public:
     /**
      * @brief Writes a compressed audio packet directly to the output file.
      * Assumes the audio stream has already been added via addAudioStreamFrom().
+     * Timestamps are rescaled from the input audio stream's time base. Safe to call from a
+     * different thread than encodeFrame().
      * @param pkt Pointer to an AVPacket containing encoded audio data.
      * @return 0 on success, a negative AVERROR code on failure.
      */
     int writeAudioPacket(AVPacket* pkt);
 
     /**
-     * @brief Encodes a single RGB24 frame.
+     * @brief Encodes a single RGB24 or YUV420P frame.
+     *
+     * YUV420P frames at the output size are sent to the encoder as they are (their pts is
+     * overwritten); RGB24 frames are converted first.
      *
-     * @param frame RGB24 AVFrame to encode (typically from AsciiRenderer; it better be).
+     * @param frame AVFrame to encode (typically from AsciiRenderer; it better be).
+     * @param frameIndex Position of the frame in the output, counted in frames of the source rate.
+     *                   Indices skipped since the previous call extend the previous frame's display
+     *                   time (variable frame rate). -1 means the frame right after the previous one.
      * @return 0 on success, or negative error code on failure.
      */
-    int encodeFrame(AVFrame* frame);
+    int encodeFrame(AVFrame* frame, int64_t frameIndex = -1);
 
     /**
      * @brief Finalizes encoding and writes file trailer.
@@ -86,7 +153,7 @@ private:
     AVStream* m_videoStream;
     AVPacket* m_packet;
 
-    // Color space conversion (RGB24 -> YUV420P for H.264)
+    // Color space conversion (RGB24 -> YUV420P for H.264), skipped for frames already in YUV420P
     SwsContext* m_swsContext;
     AVFrame* m_yuvFrame;
     uint8_t* m_yuvBuffer;
@@ -95,14 +162,22 @@ private:
     int m_width;
     int m_height;
     AVRational m_timeBase;
-    int64_t m_frameCount;
+    int64_t m_frameCount;          ///< Frames encoded
+    int64_t m_nextPts = 0;         ///< pts of a frame encoded without an explicit index
 
     AVStream* m_audioStream = nullptr;
+    AVRational m_inputAudioTimeBase = {0, 1}; ///< Time base of the source audio stream
 
     bool m_hasAudio = false;
 
+    ContainerFormat m_container = ContainerFormat::MP4;
+
+    // The header is written on the first packet so streams can still be added after init()
+    bool m_headerWritten = false;
+    std::mutex m_muxMutex; ///< Serializes muxer access between video and audio writers
+
     AVStream* m_outputVideoStream; // Pointer to the video stream in m_formatContext (output)
-    AVStream* m_outputAudioStream; // Pointer to the audio stream in m_formatContext (output)
+    AVStream* m_outputAudioStream = nullptr; // Pointer to the audio stream in m_formatContext (output)
     int m_outputVideoCodecId;      // Codec ID of the output video stream
     int m_outputAudioCodecId;      // Codec ID of the output audio stream
     int m_outputVideoStreamIndex;  // Index of the video stream in the output format context
@@ -113,6 +188,11 @@ private:
      */
     int writePacket(AVPacket* packet);
 
+    /**
+     * @brief Writes the container header if it has not been written yet. Caller holds m_muxMutex.
+     */
+    int ensureHeader();
+
     /**
      * @brief Cleans up all allocated resources.
      */
@@ -18,6 +18,7 @@ void test_ascii_grid_empty() {
     AsciiGrid grid;
     assert(grid.rows == 0);
     assert(grid.cols == 0);
+    assert(grid.stride == 0);
     assert(grid.chars.empty());
     assert(grid.colours.empty());
     std::cout << "Empty AsciiGrid test passed\n";
@@ -25,18 +26,69 @@ void test_ascii_grid_empty() {
 
 void test_ascii_grid_resize() {
     AsciiGrid grid;
-    grid.rows = 2;
-    grid.cols = 3;
-    grid.chars.resize(grid.rows, std::vector<char>(grid.cols, 'X'));
-    grid.colours.resize(grid.rows, std::vector<RGB>(grid.cols, RGB{100, 150, 200}));
+    grid.resize(2, 3);
     
-    assert(grid.chars.size() == 2);
-    assert(grid.chars[0].size() == 3);
-    assert(grid.chars[1][2] == 'X');
-    assert(grid.colours[0][1].g == 150);
+    assert(grid.rows == 2);
+    assert(grid.cols == 3);
+    assert(grid.stride >= grid.cols);
+    assert(grid.chars.size() == static_cast<size_t>(grid.rows * grid.stride));
+    assert(grid.colours.size() == grid.chars.size());
+    assert(grid.charAt(1, 2) == ' ');
+    assert(grid.colourAt(1, 2).r == 0);
+
+    grid.charAt(1, 2) = 'X';
+    grid.colourAt(0, 1) = RGB{100, 150, 200};
+    assert(grid.charAt(1, 2) == 'X');
+    assert(grid.colourAt(0, 1).g == 150);
     std::cout << "AsciiGrid resize test passed\n";
 }
 
+void test_ascii_grid_layout() {
+    AsciiGrid grid;
+    grid.resize(3, 4);
+
+    // Row-major and contiguous: a row pointer walks straight into the next row after stride cells
+    for (int row = 0; row < grid.rows; ++row) {
+        char* chars = grid.rowChars(row);
+        RGB* colours = grid.rowColours(row);
+        for (int col = 0; col < grid.cols; ++col) {
+            chars[col] = static_cast<char>('a' + row * grid.cols + col);
+            colours[col] = RGB{static_cast<uint8_t>(row), static_cast<uint8_t>(col), 0};
+        }
+    }
+    assert(grid.rowChars(1) == grid.rowChars(0) + grid.stride);
+    assert(grid.chars[grid.index(2, 3)] == 'a' + 11);
+    assert(grid.charAt(2, 3) == 'a' + 11);
+    assert(grid.colours[grid.index(2, 1)].r == 2);
+    assert(grid.colourAt(2, 1).g == 1);
+
+    const AsciiGrid& constGrid = grid;
+    assert(constGrid.rowColours(1)[3].g == 3);
+    std::cout << "AsciiGrid layout test passed\n";
+}
+
+void test_ascii_grid_same_cells() {
+    AsciiGrid grid;
+    grid.resize(4, 4);
+    for (int cell = 0; cell < 16; ++cell) {
+        grid.colours[cell] = RGB{static_cast<uint8_t>(cell), 100, 200};
+    }
+    AsciiGrid changed = grid;
+    assert(changed.sameCells(grid) && changed.hash() == grid.hash());
+
+    // Blue of cells 7 and 15 is the top byte of colour words 2 and 5. Flipping the top bit of both
+    // cancels out in the hash, so only sameCells() tells these grids apart.
+    changed.colours[7].b = 72;
+    changed.colours[15].b = 72;
+    assert(changed.hash() == grid.hash());
+    assert(!changed.sameCells(grid));
+
+    changed = grid;
+    changed.charAt(3, 3) = '#';
+    assert(!changed.sameCells(grid));
+    std::cout << "AsciiGrid sameCells test passed\n";
+}
+
 int main() {
     std::cout << "Running basic types tests...\n";
     
@@ -44,6 +96,8 @@ int main() {
         test_rgb_struct();
         test_ascii_grid_empty();
         test_ascii_grid_resize();
+        test_ascii_grid_layout();
+        test_ascii_grid_same_cells();
         
         std::cout << "All basic types tests passed!\n";
         return 0;
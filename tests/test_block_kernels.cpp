@@ -0,0 +1,89 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "BlockKernels.hpp"
+
+using namespace AsciiVideoFilter;
+
+void test_scalar_matches_reference_formula() {
+    const uint8_t pixels[] = {255, 255, 255, 0, 0, 0, 10, 20, 30, 200, 100, 50};
+    BlockSums sums;
+    BlockKernels::sumScalar(pixels, 12, 4, 1, sums);
+
+    assert(sums.r == 255 + 0 + 10 + 200);
+    assert(sums.g == 255 + 0 + 20 + 100);
+    assert(sums.b == 255 + 0 + 30 + 50);
+    int expected = 0;
+    for (int i = 0; i < 4; ++i) {
+        expected += (pixels[i * 3] * 299 + pixels[i * 3 + 1] * 587 + pixels[i * 3 + 2] * 114) / 1000;
+    }
+    assert(sums.brightness == static_cast<uint32_t>(expected));
+    std::cout << "Scalar kernel reference test passed\n";
+}
+
+void test_kernels_match_scalar() {
+    const int width = 67, height = 41; // odd sizes exercise every tail path
+    const int stride = width * 3 + 5;
+    std::vector<uint8_t> image(stride * height + BlockKernels::kReadPadding);
+    std::mt19937 rng(1234);
+    for (auto& byte : image) {
+        byte = static_cast<uint8_t>(rng());
+    }
+
+    const int blockSizes[][2] = {{1, 1}, {3, 5}, {4, 8}, {7, 3}, {8, 12}, {12, 7}, {16, 16}, {33, 9}};
+    for (const auto& kernel : BlockKernels::available()) {
+        for (const auto& size : blockSizes) {
+            for (int y = 0; y + size[1] <= height; y += size[1]) {
+                for (int x = 0; x + size[0] <= width; x += size[0]) {
+                    const uint8_t* block = image.data() + y * stride + x * 3;
+                    BlockSums expected, actual;
+                    BlockKernels::sumScalar(block, stride, size[0], size[1], expected);
+                    kernel.fn(block, stride, size[0], size[1], actual);
+                    assert(actual.r == expected.r);
+                    assert(actual.g == expected.g);
+                    assert(actual.b == expected.b);
+                    assert(actual.brightness == expected.brightness);
+                }
+            }
+        }
+        std::cout << "Kernel '" << kernel.name << "' matches scalar\n";
+    }
+}
+
+void test_kernels_extreme_values() {
+    // Every luminance that truncates differently: all white, and values just below a multiple of 1000
+    for (int value : {0, 1, 254, 255}) {
+        std::vector<uint8_t> image(16 * 3 * 2 + BlockKernels::kReadPadding, static_cast<uint8_t>(value));
+        BlockSums expected;
+        BlockKernels::sumScalar(image.data(), 16 * 3, 16, 2, expected);
+        for (const auto& kernel : BlockKernels::available()) {
+            BlockSums actual;
+            kernel.fn(image.data(), 16 * 3, 16, 2, actual);
+            assert(actual.brightness == expected.brightness);
+            assert(actual.r == expected.r);
+        }
+    }
+    std::cout << "Kernel extreme values test passed\n";
+}
+
+int main() {
+    std::cout << "Running block kernel tests...\n";
+
+    try {
+        test_scalar_matches_reference_formula();
+        test_kernels_match_scalar();
+        test_kernels_extreme_values();
+
+        std::cout << "All block kernel tests passed!\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    } catch (...) {
+        std::cerr << "Unknown test failure\n";
+        return 1;
+    }
+}
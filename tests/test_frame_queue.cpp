@@ -0,0 +1,101 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "FrameQueue.hpp"
+
+using namespace AsciiVideoFilter;
+
+void test_spsc_ring_capacity_rounds_up() {
+    SpscRing<int> ring(3);
+    assert(ring.capacity() == 4);
+    SpscRing<int> exact(8);
+    assert(exact.capacity() == 8);
+    std::cout << "SpscRing capacity test passed\n";
+}
+
+void test_spsc_ring_fifo_order() {
+    SpscRing<int> ring(4);
+    for (int i = 0; i < 4; ++i) {
+        int item = i;
+        assert(ring.push(item));
+    }
+    assert(ring.size() == 4);
+    for (int i = 0; i < 4; ++i) {
+        int out = -1;
+        assert(ring.pop(out));
+        assert(out == i);
+    }
+    assert(ring.size() == 0);
+    std::cout << "SpscRing FIFO order test passed\n";
+}
+
+void test_spsc_ring_close_drains_then_fails() {
+    SpscRing<int> ring(4);
+    int item = 7;
+    assert(ring.push(item));
+    ring.close();
+
+    item = 8;
+    assert(!ring.push(item));
+    int out = -1;
+    assert(ring.pop(out) && out == 7);
+    assert(!ring.pop(out));
+    std::cout << "SpscRing close test passed\n";
+}
+
+void test_spsc_ring_close_wakes_blocked_consumer() {
+    SpscRing<int> ring(2);
+    std::thread consumer([&]() {
+        int out = 0;
+        assert(!ring.pop(out)); // Parks on the empty ring until close()
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ring.close();
+    consumer.join();
+    std::cout << "SpscRing close wake-up test passed\n";
+}
+
+void test_spsc_ring_two_threads_keep_order() {
+    // A tiny ring forces both sides through the full/empty waits many times
+    const int64_t count = 200000;
+    SpscRing<int64_t> ring(2);
+    std::thread producer([&]() {
+        for (int64_t i = 0; i < count; ++i) {
+            int64_t item = i;
+            assert(ring.push(item));
+        }
+        ring.close();
+    });
+
+    int64_t expected = 0;
+    int64_t out = 0;
+    while (ring.pop(out)) {
+        assert(out == expected);
+        expected++;
+    }
+    producer.join();
+    assert(expected == count);
+    std::cout << "SpscRing two-thread ordering test passed\n";
+}
+
+int main() {
+    try {
+        test_spsc_ring_capacity_rounds_up();
+        test_spsc_ring_fifo_order();
+        test_spsc_ring_close_drains_then_fails();
+        test_spsc_ring_close_wakes_blocked_consumer();
+        test_spsc_ring_two_threads_keep_order();
+
+        std::cout << "All frame queue tests passed!\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    } catch (...) {
+        std::cerr << "Unknown test failure\n";
+        return 1;
+    }
+}
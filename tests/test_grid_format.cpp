@@ -0,0 +1,148 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "GridReader.hpp"
+#include "GridWriter.hpp"
+
+using namespace AsciiVideoFilter;
+
+static const char* kChars = " .:-=+*#%@";
+
+// Frames that change a few cells each, with a full change every 40 frames (a forced key frame)
+static std::vector<AsciiGrid> makeFrames(int rows, int cols, int count) {
+    std::mt19937 rng(7);
+    AsciiGrid grid;
+    grid.resize(rows, cols);
+    std::vector<AsciiGrid> frames;
+    for (int frame = 0; frame < count; ++frame) {
+        const int changes = frame % 40 == 0 ? rows * cols : 25;
+        for (int i = 0; i < changes; ++i) {
+            const int row = static_cast<int>(rng() % rows);
+            const int col = static_cast<int>(rng() % cols);
+            grid.charAt(row, col) = kChars[rng() % 10];
+            grid.colourAt(row, col) = RGB{static_cast<uint8_t>(rng()), static_cast<uint8_t>(row), static_cast<uint8_t>(col)};
+        }
+        frames.push_back(grid);
+    }
+    return frames;
+}
+
+static bool sameGrid(const AsciiGrid& a, const AsciiGrid& b, bool colour) {
+    if (a.chars != b.chars) {
+        return false;
+    }
+    return !colour || std::memcmp(a.colours.data(), b.colours.data(), a.colours.size() * sizeof(RGB)) == 0;
+}
+
+static void writeFrames(const std::string& path, const std::vector<AsciiGrid>& frames, bool colour) {
+    GridWriter writer;
+    writer.setKeyframeInterval(30);
+    assert(writer.open(path, frames[0].rows, frames[0].cols, AVRational{25, 1}, colour) == 0);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        assert(writer.writeFrame(frames[i], static_cast<int64_t>(i) * 2) == 0);
+    }
+    assert(writer.close() == 0);
+}
+
+void test_sequential_round_trip() {
+    const std::string path = "test_grid_sequential.agrid";
+    const std::vector<AsciiGrid> frames = makeFrames(9, 17, 100);
+    writeFrames(path, frames, true);
+
+    GridReader reader;
+    assert(reader.open(path) == 0);
+    assert(reader.getRows() == 9 && reader.getCols() == 17);
+    assert(reader.hasColour());
+    assert(reader.getFrameRate().num == 25 && reader.getFrameRate().den == 1);
+    assert(reader.getFrameCount() == 100);
+    for (int64_t i = 0; i < reader.getFrameCount(); ++i) {
+        assert(reader.readFrame(i) == 0);
+        assert(reader.getPts(i) == i * 2);
+        assert(sameGrid(reader.getGrid(), frames[i], true));
+    }
+    assert(reader.readFrame(100) < 0);
+    reader.close();
+    std::remove(path.c_str());
+    std::cout << "Grid sequential round trip test passed\n";
+}
+
+void test_random_seeks() {
+    const std::string path = "test_grid_seeks.agrid";
+    const std::vector<AsciiGrid> frames = makeFrames(6, 11, 120);
+    writeFrames(path, frames, true);
+
+    GridReader reader;
+    assert(reader.open(path) == 0);
+    std::mt19937 rng(3);
+    for (int i = 0; i < 200; ++i) {
+        const int64_t frame = rng() % 120;
+        assert(reader.readFrame(frame) == 0);
+        assert(sameGrid(reader.getGrid(), frames[frame], true));
+    }
+    // Backwards across a key frame, then forward again
+    assert(reader.readFrame(95) == 0 && sameGrid(reader.getGrid(), frames[95], true));
+    assert(reader.readFrame(31) == 0 && sameGrid(reader.getGrid(), frames[31], true));
+    assert(reader.readFrame(32) == 0 && sameGrid(reader.getGrid(), frames[32], true));
+
+    assert(reader.findFrame(0) == 0);
+    assert(reader.findFrame(7) == 4);  // pts 8
+    assert(reader.findFrame(8) == 4);
+    assert(reader.findFrame(1000) == 120);
+    std::remove(path.c_str());
+    std::cout << "Grid random seek test passed\n";
+}
+
+void test_monochrome_is_white() {
+    const std::string path = "test_grid_mono.agrid";
+    const std::vector<AsciiGrid> frames = makeFrames(4, 5, 10);
+    writeFrames(path, frames, false);
+
+    GridReader reader;
+    assert(reader.open(path) == 0);
+    assert(!reader.hasColour());
+    for (int64_t i = 0; i < reader.getFrameCount(); ++i) {
+        assert(reader.readFrame(i) == 0);
+        assert(sameGrid(reader.getGrid(), frames[i], false));
+        const RGB& colour = reader.getGrid().colourAt(3, 4);
+        assert(colour.r == 255 && colour.g == 255 && colour.b == 255);
+    }
+    std::remove(path.c_str());
+    std::cout << "Grid monochrome test passed\n";
+}
+
+void test_rejects_bad_files() {
+    const std::string path = "test_grid_bad.agrid";
+    FILE* file = std::fopen(path.c_str(), "wb");
+    const char junk[64] = "definitely not a grid file";
+    std::fwrite(junk, 1, sizeof(junk), file);
+    std::fclose(file);
+
+    GridReader reader;
+    assert(reader.open(path) == AVERROR_INVALIDDATA);
+    assert(reader.open("does_not_exist.agrid") < 0);
+    std::remove(path.c_str());
+    std::cout << "Grid bad file test passed\n";
+}
+
+int main() {
+    try {
+        test_sequential_round_trip();
+        test_random_seeks();
+        test_monochrome_is_white();
+        test_rejects_bad_files();
+
+        std::cout << "All grid format tests passed!\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    } catch (...) {
+        std::cerr << "Unknown test failure\n";
+        return 1;
+    }
+}
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+extern "C" {
+    #include <libavcodec/avcodec.h>
+    #include <libavformat/avformat.h>
+    #include <libavutil/frame.h>
+    #include <libavutil/opt.h>
+}
+
+#include "AsciiConverter.hpp"
+#include "VideoDecoder.hpp"
+
+using namespace AsciiVideoFilter;
+
+// x264 SPS with max_num_ref_frames 1, as avcC extradata (from an mp4)
+static const uint8_t kAvccOneReference[] = {
+    0x01, 0x64, 0x00, 0x0a, 0xff, 0xe1, 0x00, 0x15, 0x67, 0x64, 0x00, 0x0a, 0xac, 0xb4, 0x23, 0xd0,
+    0x80, 0x00, 0x00, 0x03, 0x00, 0x80, 0x00, 0x00, 0x19, 0x07, 0x89, 0x13, 0x50, 0x01, 0x00, 0x05,
+    0x68, 0xef, 0x0f, 0x2c, 0x8b, 0xfd, 0xf8, 0xf8, 0x00
+};
+
+// x264 SPS with max_num_ref_frames 3, as Annex B extradata (from an MPEG-TS)
+static const uint8_t kAnnexBThreeReferences[] = {
+    0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x0a, 0xac, 0xb2, 0x08, 0xf4, 0x20, 0x00, 0x00, 0x03, 0x00,
+    0x20, 0x00, 0x00, 0x06, 0x41, 0xe2, 0x44, 0xc9, 0x00, 0x00, 0x00, 0x01, 0x68, 0xeb, 0xc3, 0xcb,
+    0x22, 0xc0
+};
+
+// Encodes a still background with a small box moving across it, P frames only
+static bool encodeClip(const std::string& path, int references, int frameCount) {
+    const AVCodec* codec = avcodec_find_encoder_by_name("libx264");
+    if (!codec) {
+        return false;
+    }
+    AVFormatContext* format = nullptr;
+    assert(avformat_alloc_output_context2(&format, nullptr, nullptr, path.c_str()) >= 0);
+    AVStream* stream = avformat_new_stream(format, nullptr);
+    AVCodecContext* context = avcodec_alloc_context3(codec);
+    context->width = 64;
+    context->height = 48;
+    context->pix_fmt = AV_PIX_FMT_YUV420P;
+    context->time_base = AVRational{1, 25};
+    context->framerate = AVRational{25, 1};
+    context->gop_size = 250;
+    context->max_b_frames = 0;
+    if (format->oformat->flags & AVFMT_GLOBALHEADER) {
+        context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    const std::string params = "ref=" + std::to_string(references) + ":bframes=0:scenecut=0";
+    av_opt_set(context->priv_data, "x264-params", params.c_str(), 0);
+    assert(avcodec_open2(context, codec, nullptr) == 0);
+    assert(avcodec_parameters_from_context(stream->codecpar, context) >= 0);
+    stream->time_base = context->time_base;
+    assert(avio_open(&format->pb, path.c_str(), AVIO_FLAG_WRITE) >= 0);
+    assert(avformat_write_header(format, nullptr) >= 0);
+
+    AVFrame* frame = av_frame_alloc();
+    frame->format = context->pix_fmt;
+    frame->width = context->width;
+    frame->height = context->height;
+    assert(av_frame_get_buffer(frame, 0) == 0);
+    AVPacket* packet = av_packet_alloc();
+    for (int i = 0; i <= frameCount; ++i) {
+        AVFrame* input = nullptr;
+        if (i < frameCount) {
+            assert(av_frame_make_writable(frame) == 0);
+            for (int y = 0; y < frame->height; ++y) {
+                for (int x = 0; x < frame->width; ++x) {
+                    const bool box = y >= 16 && y < 32 && x >= i && x < i + 16;
+                    frame->data[0][y * frame->linesize[0] + x] = box ? 230 : static_cast<uint8_t>(40 + x);
+                }
+            }
+            for (int plane = 1; plane < 3; ++plane) {
+                for (int y = 0; y < frame->height / 2; ++y) {
+                    for (int x = 0; x < frame->width / 2; ++x) {
+                        frame->data[plane][y * frame->linesize[plane] + x] = 128;
+                    }
+                }
+            }
+            frame->pts = i;
+            input = frame;
+        }
+        assert(avcodec_send_frame(context, input) == 0);
+        while (avcodec_receive_packet(context, packet) == 0) {
+            av_packet_rescale_ts(packet, context->time_base, stream->time_base);
+            packet->stream_index = stream->index;
+            assert(av_interleaved_write_frame(format, packet) == 0);
+        }
+    }
+    assert(av_write_trailer(format) == 0);
+
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&context);
+    avio_closep(&format->pb);
+    avformat_free_context(format);
+    return true;
+}
+
+// Converts the whole clip with motion skip, set up the way Application does
+static double recomputedFraction(const std::string& path, int& referenceFrames) {
+    VideoDecoder decoder;
+    decoder.setExportMotionVectors(true);
+    assert(decoder.open(path) == 0);
+    referenceFrames = decoder.getReferenceFrames();
+
+    AsciiConverter converter;
+    converter.setConversionMode(ConversionMode::YUV);
+    converter.setMotionSkip(true);
+    converter.setReorderDelay(decoder.getReorderDelay());
+    converter.setReferenceFrames(referenceFrames);
+    assert(converter.init(decoder.getWidth(), decoder.getHeight(), decoder.getPixelFormat(), 4, 8) == 0);
+
+    AVFrame* frame = av_frame_alloc();
+    AsciiGrid grid;
+    while (decoder.readFrame(frame)) {
+        converter.convert(frame, grid);
+        av_frame_unref(frame);
+    }
+    av_frame_free(&frame);
+    return converter.getAverageRecomputedFraction();
+}
+
+void test_parse_reference_frames() {
+    assert(VideoDecoder::parseH264ReferenceFrames(kAvccOneReference, sizeof(kAvccOneReference)) == 1);
+    assert(VideoDecoder::parseH264ReferenceFrames(kAnnexBThreeReferences, sizeof(kAnnexBThreeReferences)) == 3);
+    // Truncated SPS, PPS only, nothing at all
+    assert(VideoDecoder::parseH264ReferenceFrames(kAnnexBThreeReferences, 9) == -1);
+    assert(VideoDecoder::parseH264ReferenceFrames(kAnnexBThreeReferences + 24, sizeof(kAnnexBThreeReferences) - 24) == -1);
+    assert(VideoDecoder::parseH264ReferenceFrames(nullptr, 0) == -1);
+    std::cout << "SPS reference frame parsing test passed\n";
+}
+
+void test_single_reference_skips() {
+    const std::string path = "test_motion_skip_ref1.mp4";
+    if (!encodeClip(path, 1, 30)) {
+        std::cout << "libx264 not available, single reference test skipped\n";
+        return;
+    }
+    int referenceFrames = 0;
+    const double fraction = recomputedFraction(path, referenceFrames);
+    assert(referenceFrames == 1);
+    assert(fraction < 1.0);
+    std::remove(path.c_str());
+    std::cout << "Single reference motion skip test passed\n";
+}
+
+void test_multiple_references_convert_in_full() {
+    // Zero vectors of a multi-reference P frame may point two or three frames back
+    const std::string path = "test_motion_skip_ref3.mp4";
+    if (!encodeClip(path, 3, 30)) {
+        std::cout << "libx264 not available, multiple reference test skipped\n";
+        return;
+    }
+    int referenceFrames = 0;
+    const double fraction = recomputedFraction(path, referenceFrames);
+    assert(referenceFrames == 3);
+    assert(fraction == 1.0);
+    std::remove(path.c_str());
+    std::cout << "Multiple reference motion skip test passed\n";
+}
+
+int main() {
+    try {
+        test_parse_reference_frames();
+        test_single_reference_skips();
+        test_multiple_references_convert_in_full();
+
+        std::cout << "All motion skip tests passed!\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    } catch (...) {
+        std::cerr << "Unknown test failure\n";
+        return 1;
+    }
+}
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Stats.hpp"
+
+using namespace AsciiVideoFilter;
+
+static std::string readFile(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+void test_disabled_records_nothing() {
+    Stats::reset();
+    Stats::setEnabled(false);
+    {
+        Stats::ScopedTimer timer(Stage::Render);
+    }
+    Stats::record(Stage::Decode, 1000000);
+
+    const std::string path = "test_stats_disabled.json";
+    assert(Stats::writeJson(path, 0, 0.0) == 0);
+    const std::string json = readFile(path);
+    assert(json.find("{\"name\": \"decode\", \"samples\": 0,") != std::string::npos);
+    assert(json.find("{\"name\": \"render\", \"samples\": 0,") != std::string::npos);
+    std::remove(path.c_str());
+    std::cout << "Stats disabled test passed\n";
+}
+
+void test_percentiles() {
+    Stats::reset();
+    Stats::setEnabled(true);
+    // 1..100 ms: nearest-rank p50 = 50, p95 = 95, p99 = 99
+    for (int ms = 100; ms >= 1; --ms) {
+        Stats::record(Stage::Encode, static_cast<int64_t>(ms) * 1000000);
+    }
+
+    const std::string path = "test_stats_percentiles.json";
+    assert(Stats::writeJson(path, 100, 2.0) == 0);
+    const std::string json = readFile(path);
+    assert(json.find("\"frames\": 100,") != std::string::npos);
+    assert(json.find("\"fps\": 50.000,") != std::string::npos);
+    assert(json.find("{\"name\": \"encode\", \"samples\": 100, \"total_ms\": 5050.000, \"mean_ms\": 50.5000, "
+                     "\"p50_ms\": 50.0000, \"p95_ms\": 95.0000, \"p99_ms\": 99.0000, \"max_ms\": 100.0000}") != std::string::npos);
+    std::remove(path.c_str());
+
+    Stats::setEnabled(false);
+    Stats::reset();
+    std::cout << "Stats percentile test passed\n";
+}
+
+void test_scoped_timer_records_one_sample() {
+    Stats::reset();
+    Stats::setEnabled(true);
+    {
+        Stats::ScopedTimer timer(Stage::Mux);
+    }
+
+    const std::string path = "test_stats_timer.json";
+    assert(Stats::writeJson(path, 1, 1.0) == 0);
+    assert(readFile(path).find("{\"name\": \"mux\", \"samples\": 1,") != std::string::npos);
+    std::remove(path.c_str());
+
+    Stats::setEnabled(false);
+    Stats::reset();
+    std::cout << "Stats scoped timer test passed\n";
+}
+
+void test_samples_merged_across_threads() {
+    Stats::reset();
+    Stats::setEnabled(true);
+    // Each thread records into its own buffers; the report has to see all of them
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([]() {
+            for (int i = 0; i < 1000; ++i) {
+                Stats::record(Stage::Render, 2000000);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    Stats::record(Stage::Render, 2000000);
+
+    const std::string path = "test_stats_threads.json";
+    assert(Stats::writeJson(path, 4001, 1.0) == 0);
+    assert(readFile(path).find("{\"name\": \"render\", \"samples\": 4001, \"total_ms\": 8002.000,") != std::string::npos);
+    std::remove(path.c_str());
+
+    // reset() clears the buffers of threads that have already exited too
+    Stats::reset();
+    assert(Stats::writeJson(path, 0, 0.0) == 0);
+    assert(readFile(path).find("{\"name\": \"render\", \"samples\": 0,") != std::string::npos);
+    std::remove(path.c_str());
+
+    Stats::setEnabled(false);
+    std::cout << "Stats multi-thread samples test passed\n";
+}
+
+static size_t countOccurrences(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1)) {
+        count++;
+    }
+    return count;
+}
+
+void test_trace_spans_from_two_threads() {
+    Stats::setTracing(true);
+    Stats::setThreadName("main");
+    {
+        Stats::ScopedTimer timer(Stage::Encode);
+    }
+    std::thread worker([]() {
+        Stats::setThreadName("decode");
+        for (int i = 0; i < 3; ++i) {
+            Stats::ScopedTimer timer(Stage::Decode);
+        }
+    });
+    worker.join();
+
+    const std::string path = "test_stats_trace.json";
+    assert(Stats::writeTrace(path) == 0);
+    Stats::setTracing(false);
+    const std::string json = readFile(path);
+    assert(json.find("\"traceEvents\"") != std::string::npos);
+    assert(countOccurrences(json, "\"ph\": \"X\"") == 4);
+    assert(countOccurrences(json, "{\"name\": \"decode\", \"cat\": \"stage\"") == 3);
+    assert(json.find("\"args\": {\"name\": \"decode\"}") != std::string::npos);
+    std::remove(path.c_str());
+    std::cout << "Stats trace test passed\n";
+}
+
+int main() {
+    try {
+        test_disabled_records_nothing();
+        test_percentiles();
+        test_scoped_timer_records_one_sample();
+        test_samples_merged_across_threads();
+        test_trace_spans_from_two_threads();
+
+        std::cout << "All stats tests passed!\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    } catch (...) {
+        std::cerr << "Unknown test failure\n";
+        return 1;
+    }
+}
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+using namespace AsciiVideoFilter;
+
+void test_every_task_runs_once() {
+    ThreadPool pool(4);
+    assert(pool.getThreadCount() == 4);
+
+    std::vector<int> runs(1000, 0);
+    pool.parallelFor(static_cast<int>(runs.size()), [&](int task, int thread) {
+        assert(thread >= 0 && thread < 4);
+        runs[task]++;
+    });
+    for (int count : runs) {
+        assert(count == 1);
+    }
+    std::cout << "ThreadPool task coverage test passed\n";
+}
+
+void test_repeated_batches() {
+    // Back-to-back batches must not leak tasks from one into the next
+    ThreadPool pool(3);
+    std::atomic<int> total{0};
+    for (int batch = 0; batch < 2000; ++batch) {
+        pool.parallelFor(7, [&](int, int) { total++; });
+        assert(total == (batch + 1) * 7);
+    }
+    std::cout << "ThreadPool repeated batch test passed\n";
+}
+
+void test_single_thread_runs_inline() {
+    ThreadPool pool(1);
+    assert(pool.getThreadCount() == 1);
+    int sum = 0;
+    pool.parallelFor(10, [&](int task, int thread) {
+        assert(thread == 0);
+        sum += task;
+    });
+    assert(sum == 45);
+    std::cout << "ThreadPool single-thread test passed\n";
+}
+
+int main() {
+    try {
+        test_every_task_runs_once();
+        test_repeated_batches();
+        test_single_thread_runs_inline();
+
+        std::cout << "All thread pool tests passed!\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << "\n";
+        return 1;
+    } catch (...) {
+        std::cerr << "Unknown test failure\n";
+        return 1;
+    }
+}